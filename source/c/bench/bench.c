@@ -0,0 +1,941 @@
+/* vim: set noet tw=78 si: */
+/*!
+ * OpenThread NTP Client: host-side benchmark and trace driver
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ *
+ * Builds the client library against the OpenThread stub (ot_stub.c) and
+ * drives the state machine with synthetic replies.  Reports the per-call
+ * cost of ntp_client_process() in each resting state, the per-packet cost
+ * of the receive path, and the observable behaviour of the timeout/retry
+ * and Kiss-o'-Death machinery under scripted packet traces.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "ntp.h"
+#include "ntp_clock.h"
+#include "ntp_persist.h"
+#include "ntp_discover.h"
+#include "ntp_servers.h"
+#include "ntp_wheel.h"
+#include "ntp_wire.h"
+#include "ot_stub.h"
+
+/*! Iterations for the cheap per-call measurements */
+#define BENCH_ITERS_FAST	(1000000)
+
+/*! Iterations for the full-exchange measurement */
+#define BENCH_ITERS_EXCHANGE	(20000)
+
+/*! Seconds between the NTP and UNIX epochs */
+#define BENCH_NTP_DELTA		(2208988800ull)
+
+static uint32_t _handler_calls;
+static int _failures;
+
+static void _bench_handler(struct ntp_client_t* ntp_client) {
+	(void)ntp_client;
+	_handler_calls++;
+}
+
+/* Monotonic nanoseconds, for measuring ourselves (not the virtual clock) */
+static uint64_t _bench_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static void _bench_check(bool cond, const char* what) {
+	if (!cond) {
+		printf("FAIL: %s\n", what);
+		_failures++;
+	}
+}
+
+/* A unicast server address and the multicast all-nodes address */
+static otIp6Address _server_addr;
+static otIp6Address _mcast_addr;
+
+static void _bench_addrs_init(void) {
+	memset(&_server_addr, 0, sizeof(_server_addr));
+	_server_addr.mFields.m8[0] = 0xfd;
+	_server_addr.mFields.m8[15] = 0x01;
+	memset(&_mcast_addr, 0, sizeof(_mcast_addr));
+	_mcast_addr.mFields.m8[0] = 0xff;
+	_mcast_addr.mFields.m8[1] = 0x02;
+	_mcast_addr.mFields.m8[15] = 0x01;
+}
+
+/*
+ * Build a server packet.  For a unicast reply (mode 4) the originate
+ * time-stamp echoes the transmit time-stamp of the last request captured
+ * by the stub, as a real server would.
+ */
+static void _bench_make_packet(uint8_t* pkt, uint8_t mode, uint8_t stratum,
+		uint8_t poll) {
+	static uint32_t srv_s = 3700000000u;
+
+	memset(pkt, 0, NTP_WIRE_PACKET_SIZE);
+	pkt[NTP_WIRE_OFF_FLAGS] = (uint8_t)(0x20 | mode);	/* vn = 4 */
+	pkt[NTP_WIRE_OFF_STRATUM] = stratum;
+	pkt[NTP_WIRE_OFF_POLL] = poll;
+
+	if (mode == 4) {
+		memcpy(pkt + NTP_WIRE_OFF_ORIG_TM_S,
+				ot_stub_last_tx + NTP_WIRE_OFF_TX_TM_S, 8);
+	}
+
+	srv_s++;
+	ntp_wire_put_u32(pkt, NTP_WIRE_OFF_RX_TM_S, srv_s);
+	ntp_wire_put_u32(pkt, NTP_WIRE_OFF_RX_TM_F, 0x40000000);
+	ntp_wire_put_u32(pkt, NTP_WIRE_OFF_TX_TM_S, srv_s);
+	ntp_wire_put_u32(pkt, NTP_WIRE_OFF_TX_TM_F, 0x50000000);
+}
+
+/* Deliver a packet to the client's socket as if from the server */
+static void _bench_deliver(struct ntp_client_t* client, const uint8_t* pkt,
+		bool bc) {
+	otMessageInfo msg_info;
+	memset(&msg_info, 0, sizeof(msg_info));
+	memcpy(&(msg_info.mPeerAddr), &_server_addr, sizeof(otIp6Address));
+	memcpy(&(msg_info.mSockAddr), bc ? &_mcast_addr : &_server_addr,
+			sizeof(otIp6Address));
+	msg_info.mPeerPort = NTP_CLIENT_DEFAULT_PORT;
+	ot_stub_deliver(&(client->socket), pkt, NTP_WIRE_PACKET_SIZE,
+			&msg_info);
+}
+
+/* Cost of ntp_client_process() when there is nothing to do */
+static void _bench_process_cost(void) {
+	static struct ntp_client_t client;
+	uint8_t pkt[NTP_WIRE_PACKET_SIZE];
+	uint64_t t0;
+	uint32_t n;
+
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+
+	/* Resting in a final state (the common post-poll case) */
+	client.state = NTP_CLIENT_DONE;
+	t0 = _bench_now_ns();
+	for (n = 0; n < BENCH_ITERS_FAST; n++)
+		ntp_client_process(&client);
+	printf("process(), done state:      %6.1f ns/call\n",
+			(double)(_bench_now_ns() - t0) / BENCH_ITERS_FAST);
+
+	/* Waiting on a reply, no event queued, deadline not reached */
+	memset(&client, 0, sizeof(client));
+	_bench_check(ntp_client_begin(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"begin (process cost)");
+	t0 = _bench_now_ns();
+	for (n = 0; n < BENCH_ITERS_FAST; n++)
+		ntp_client_process(&client);
+	printf("process(), awaiting reply:  %6.1f ns/call\n",
+			(double)(_bench_now_ns() - t0) / BENCH_ITERS_FAST);
+	_bench_check(client.state == NTP_CLIENT_SENT,
+			"client still awaiting reply");
+
+	/* Let it finish cleanly */
+	_bench_make_packet(pkt, 4, 2, 0);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+	_bench_check(client.state == NTP_CLIENT_DONE,
+			"poll completes after process cost run");
+
+	/* Listening, ring empty */
+	memset(&client, 0, sizeof(client));
+	_bench_check(ntp_client_listen(ot_stub_instance(), &client,
+				&_mcast_addr, NTP_CLIENT_DEFAULT_PORT,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"listen (process cost)");
+	t0 = _bench_now_ns();
+	for (n = 0; n < BENCH_ITERS_FAST; n++)
+		ntp_client_process(&client);
+	printf("process(), listen idle:     %6.1f ns/call\n",
+			(double)(_bench_now_ns() - t0) / BENCH_ITERS_FAST);
+	ntp_client_shutdown(&client);
+}
+
+/* Per-packet cost of the receive path (callback plus drain) */
+static void _bench_recv_cost(void) {
+	static struct ntp_client_t client;
+	uint8_t pkt[NTP_WIRE_PACKET_SIZE];
+	uint64_t t0;
+	uint32_t n;
+
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+	_bench_check(ntp_client_listen(ot_stub_instance(), &client,
+				&_mcast_addr, NTP_CLIENT_DEFAULT_PORT,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"listen (recv cost)");
+
+	_bench_make_packet(pkt, 5, 2, 6);
+	_handler_calls = 0;
+
+	t0 = _bench_now_ns();
+	for (n = 0; n < BENCH_ITERS_FAST / 10; n++) {
+		_bench_deliver(&client, pkt, true);
+		ntp_client_process(&client);
+	}
+	printf("recv broadcast + process:   %6.1f ns/packet\n",
+			(double)(_bench_now_ns() - t0)
+				/ (BENCH_ITERS_FAST / 10));
+	_bench_check(_handler_calls == (BENCH_ITERS_FAST / 10),
+			"every broadcast reached the handler");
+	ntp_client_shutdown(&client);
+}
+
+/* End-to-end cost of one unicast poll: begin, reply, process, done */
+static void _bench_exchange_cost(void) {
+	static struct ntp_client_t client;
+	uint8_t pkt[NTP_WIRE_PACKET_SIZE];
+	uint64_t t0;
+	uint32_t n;
+
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+	_handler_calls = 0;
+
+	t0 = _bench_now_ns();
+	for (n = 0; n < BENCH_ITERS_EXCHANGE; n++) {
+		/* Step past the poll-interval throttle from the last poll */
+		ot_stub_advance_ms(1100);
+		_bench_check(ntp_client_begin(ot_stub_instance(), &client,
+					&_server_addr,
+					NTP_CLIENT_DEFAULT_PORT, 64,
+					_bench_handler, NULL)
+					== OT_ERROR_NONE,
+				"begin (exchange)");
+		_bench_make_packet(pkt, 4, 2, 0);
+		_bench_deliver(&client, pkt, false);
+		ntp_client_process(&client);
+		_bench_check(client.state == NTP_CLIENT_DONE,
+				"exchange completed");
+	}
+	printf("full unicast poll:          %6.1f ns/poll\n",
+			(double)(_bench_now_ns() - t0)
+				/ BENCH_ITERS_EXCHANGE);
+	_bench_check(_handler_calls == BENCH_ITERS_EXCHANGE,
+			"every exchange reached the handler");
+	_bench_check(ot_stub_msgs_live == 0, "no leaked messages");
+}
+
+/* Scripted traces: loss with retries, total loss, Kiss-o'-Death */
+static void _bench_traces(void) {
+	static struct ntp_client_t client;
+	uint8_t pkt[NTP_WIRE_PACKET_SIZE];
+	uint32_t attempts;
+
+	/* Two requests lost, the third answered: the poll still succeeds */
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+	ntp_client_set_retry(&client, 3);
+	_handler_calls = 0;
+	_bench_check(ntp_client_begin(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"begin (lossy trace)");
+	for (attempts = 0; attempts < 2; attempts++) {
+		ot_stub_advance_ms(ntp_client_timeout_in(&client) + 1);
+		ntp_client_process(&client);
+	}
+	_bench_check(ot_stub_udp_sends == 3, "2 losses: 3 transmissions");
+	_bench_make_packet(pkt, 4, 2, 6);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+	_bench_check(client.state == NTP_CLIENT_DONE,
+			"lossy poll recovered by retransmission");
+	_bench_check(_handler_calls == 1, "lossy poll: one handler call");
+	printf("trace, 2 losses + reply:    %u tx, final state 0x%02x\n",
+			ot_stub_udp_sends, client.state);
+
+	/* Nothing ever answers: every retry is spent, then timeout */
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+	ntp_client_set_retry(&client, 3);
+	_bench_check(ntp_client_begin(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"begin (dead trace)");
+	while (!ntp_client_is_done(&client)) {
+		ot_stub_advance_ms(ntp_client_timeout_in(&client) + 1);
+		ntp_client_process(&client);
+	}
+	_bench_check(ot_stub_udp_sends == 4, "dead server: 4 transmissions");
+	_bench_check(client.state == NTP_CLIENT_TIMEOUT,
+			"dead server: client timed out");
+	printf("trace, dead server:         %u tx, final state 0x%02x\n",
+			ot_stub_udp_sends, client.state);
+
+	/* Kiss-o'-Death: the client backs off and refuses to re-poll */
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+	_bench_check(ntp_client_begin(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"begin (KoD trace)");
+	_bench_make_packet(pkt, 4, 0, 6);
+	memcpy(pkt + NTP_WIRE_OFF_REF_ID, "RATE", 4);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+	_bench_check(client.state == NTP_CLIENT_KOD,
+			"KoD reply lands in NTP_CLIENT_KOD");
+	_bench_check(ntp_client_begin(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_BUSY,
+			"KoD backoff refuses the next poll");
+	printf("trace, Kiss-o'-Death:       backoff %u s, re-poll in"
+			" %u ms\n", client.kod_backoff_s,
+			ntp_client_poll_in(&client));
+
+	/* A configured timeout is honoured to the millisecond */
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+	ntp_client_set_timeout(&client, 500);
+	_bench_check(ntp_client_begin(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"begin (timeout trace)");
+	_bench_check(ntp_client_timeout_in(&client) == 500,
+			"configured timeout armed exactly");
+	ot_stub_advance_ms(501);
+	ntp_client_process(&client);
+	_bench_check(client.state == NTP_CLIENT_TIMEOUT,
+			"configured timeout fired");
+	printf("trace, 500 ms timeout:      fired, final state 0x%02x\n",
+			client.state);
+
+	/* Root dispersion/delay size the lazy re-poll budget */
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+	_bench_check(ntp_client_begin(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"begin (error budget trace)");
+	_bench_make_packet(pkt, 4, 2, 6);
+	/* Root delay 0.02 s, root dispersion 0.05 s (16.16 fixed point) */
+	ntp_wire_put_u32(pkt, NTP_WIRE_OFF_ROOT_DELAY, 0x0000051f);
+	ntp_wire_put_u32(pkt, NTP_WIRE_OFF_ROOT_DISP, 0x00000ccd);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+	_bench_check(client.state == NTP_CLIENT_DONE,
+			"error budget poll completed");
+	_bench_check((client.sync_err_usec > 55000)
+				&& (client.sync_err_usec < 65000),
+			"sync error bound ~60 ms");
+	_bench_check((client.ts.tv_sec == client.tv.tv_sec)
+				&& ((client.ts.tv_nsec / 1000)
+					== client.tv.tv_usec),
+			"timespec result agrees with timeval");
+	_bench_check(ntp_client_next_poll_in(&client, 50000) == 0,
+			"target under the bound: poll now");
+	uint32_t in_ms = ntp_client_next_poll_in(&client, 100000);
+	_bench_check((in_ms > 2000000) && (in_ms < 3000000),
+			"100 ms target: re-poll in ~45 min");
+	ot_stub_advance_ms(1000000);
+	_bench_check(ntp_client_next_poll_in(&client, 100000)
+				< (in_ms - 999000),
+			"budget drains as time passes");
+	printf("trace, error budget:        bound %u us, 100 ms target"
+			" re-poll in %u s\n", client.sync_err_usec,
+			in_ms / 1000);
+
+	/*
+	 * The reply to the first attempt lands after the retransmission:
+	 * it must be matched to its own T1 by the originate stamp, not
+	 * scored against the retry's — and a stray reply echoing a stamp
+	 * we never sent must not conclude the poll.
+	 */
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+	ntp_client_set_timeout(&client, 500);
+	ntp_client_set_retry(&client, 2);
+	_handler_calls = 0;
+	_bench_check(ntp_client_begin(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"begin (late reply trace)");
+	uint8_t orig1[8];
+	memcpy(orig1, ot_stub_last_tx + NTP_WIRE_OFF_TX_TM_S, 8);
+
+	ot_stub_advance_ms(501);
+	ntp_client_process(&client);
+	_bench_check(ot_stub_udp_sends == 2, "timeout retransmitted");
+
+	_bench_make_packet(pkt, 4, 2, 6);
+	memset(pkt + NTP_WIRE_OFF_ORIG_TM_S, 0x5a, 8);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+	_bench_check(client.state == NTP_CLIENT_SENT,
+			"stray reply ignored on the retry path");
+
+	_bench_make_packet(pkt, 4, 2, 6);
+	memcpy(pkt + NTP_WIRE_OFF_ORIG_TM_S, orig1, 8);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+	_bench_check(client.state == NTP_CLIENT_DONE,
+			"late reply to the first attempt accepted");
+	_bench_check(_handler_calls == 1,
+			"late reply trace: one handler call");
+	_bench_check((client.delay < -50000) && (client.delay > -70000),
+			"late reply scored against its own T1");
+	printf("trace, late reply vs retry: accepted, delay %lld us\n",
+			(long long)client.delay);
+
+	/* Buffer starvation defers the send instead of failing the poll */
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+	ot_stub_msgs_fail = 3;
+	_handler_calls = 0;
+	_bench_check(ntp_client_begin(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"begin (starved trace) still succeeds");
+	_bench_check(client.state == NTP_CLIENT_SEND_PEND,
+			"starved send deferred, not failed");
+	_bench_check(ot_stub_udp_sends == 0,
+			"nothing on the wire while starved");
+	for (attempts = 0; (client.state == NTP_CLIENT_SEND_PEND)
+			&& (attempts < 8); attempts++) {
+		ot_stub_advance_ms(ntp_client_timeout_in(&client) + 1);
+		ntp_client_process(&client);
+	}
+	_bench_check(client.state == NTP_CLIENT_SENT,
+			"deferred send went out once buffers returned");
+	_bench_check(ot_stub_udp_sends == 1,
+			"one transmission after the pool recovered");
+	_bench_check(client.stats.no_bufs == 3,
+			"three deferrals counted");
+	_bench_make_packet(pkt, 4, 2, 6);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+	_bench_check(client.state == NTP_CLIENT_DONE,
+			"starved poll completed");
+	_bench_check(_handler_calls == 1, "starved poll: one handler call");
+	printf("trace, starved buffers:     %u deferrals, %u tx, final"
+			" state 0x%02x\n", client.stats.no_bufs,
+			ot_stub_udp_sends, client.state);
+
+	/*
+	 * A concluded persistent client re-begun as a plain poll still holds
+	 * its socket: the lingering socket must be closed before the state
+	 * is wiped, not zeroed while registered with the stack.
+	 */
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+	_bench_check(ntp_client_begin_persistent(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"begin (re-begin trace)");
+	_bench_make_packet(pkt, 4, 2, 0);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+	_bench_check(client.state == NTP_CLIENT_DONE,
+			"persistent poll concluded");
+	_bench_check(ot_stub_udp_closes == 0,
+			"persistent client held its socket");
+	ot_stub_advance_ms(1100);	/* past the 1 s min-poll throttle */
+	_bench_check(ntp_client_begin(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"plain re-begin of a persistent client");
+	_bench_check(ot_stub_udp_closes == 1,
+			"lingering socket closed before the wipe");
+	_bench_check(ot_stub_udp_opens == 2,
+			"re-begin opened a fresh socket");
+	_bench_make_packet(pkt, 4, 2, 6);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+	_bench_check(client.state == NTP_CLIENT_DONE,
+			"re-begun poll concluded");
+	_bench_check(ot_stub_udp_closes == 2,
+			"plain poll released its socket when done");
+	printf("trace, persistent re-begin: lingering socket closed,"
+			" final state 0x%02x\n", client.state);
+
+	/*
+	 * A replayed copy of the previous exchange's reply must not conclude
+	 * the next poll of a re-used persistent client: the origin-stamp
+	 * ring only holds this poll's transmissions.
+	 */
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+	_handler_calls = 0;
+	_bench_check(ntp_client_begin_persistent(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"begin (replay trace)");
+	uint8_t replay[NTP_WIRE_PACKET_SIZE];
+	_bench_make_packet(replay, 4, 2, 0);
+	_bench_deliver(&client, replay, false);
+	ntp_client_process(&client);
+	_bench_check(client.state == NTP_CLIENT_DONE,
+			"replay trace: first poll concluded");
+	ot_stub_advance_ms(1100);	/* past the 1 s min-poll throttle */
+	_bench_check(ntp_client_begin_persistent(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"persistent reuse begins");
+	_bench_deliver(&client, replay, false);
+	ntp_client_process(&client);
+	_bench_check(client.state == NTP_CLIENT_SENT,
+			"replayed reply dropped on reuse");
+	_bench_make_packet(pkt, 4, 2, 6);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+	_bench_check(client.state == NTP_CLIENT_DONE,
+			"fresh reply concluded the re-used poll");
+	_bench_check(_handler_calls == 2, "replay trace: two handler calls");
+	ntp_client_shutdown(&client);
+	printf("trace, replay across polls: dropped, final state 0x%02x\n",
+			client.state);
+}
+
+/* A burst matches each reply to its own request by originate stamp */
+static void _bench_burst(void) {
+	static struct ntp_client_t client;
+	uint8_t pkt[NTP_WIRE_PACKET_SIZE];
+	uint8_t orig1[8], orig2[8], orig3[8];
+
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+	_handler_calls = 0;
+	_bench_check(ntp_client_begin_burst(ot_stub_instance(), &client,
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				3, 50, _bench_handler, NULL) == OT_ERROR_NONE,
+			"burst begin");
+	_bench_check(ot_stub_udp_sends == 1, "burst: first request immediate");
+	_bench_check(ntp_client_timeout_in(&client) == 50,
+			"burst spacing visible to the tickless loop");
+	memcpy(orig1, ot_stub_last_tx + NTP_WIRE_OFF_TX_TM_S, 8);
+
+	ot_stub_advance_ms(51);
+	ntp_client_process(&client);
+	_bench_check(ot_stub_udp_sends == 2,
+			"burst: second request on schedule");
+	memcpy(orig2, ot_stub_last_tx + NTP_WIRE_OFF_TX_TM_S, 8);
+
+	/* A reply echoing a stamp we never sent must be dropped */
+	_bench_make_packet(pkt, 4, 2, 6);
+	memset(pkt + NTP_WIRE_OFF_ORIG_TM_S, 0xa5, 8);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+	_bench_check(client.burst_recv == 0,
+			"unmatched originate stamp dropped");
+
+	/*
+	 * The reply to request 1 lands after request 2 went out.  It
+	 * carries 62.5 ms of server processing time, so once it is scored
+	 * against its own T1 it has the lowest delay of the burst and must
+	 * win the selection.
+	 */
+	_bench_make_packet(pkt, 4, 2, 6);
+	memcpy(pkt + NTP_WIRE_OFF_ORIG_TM_S, orig1, 8);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+	_bench_check(client.burst_recv == 1,
+			"late reply matched to its own request");
+	_bench_check(client.state == NTP_CLIENT_SENT,
+			"burst still collecting");
+
+	ot_stub_advance_ms(51);
+	ntp_client_process(&client);
+	_bench_check(ot_stub_udp_sends == 3,
+			"burst: third request on schedule");
+	memcpy(orig3, ot_stub_last_tx + NTP_WIRE_OFF_TX_TM_S, 8);
+
+	/* Replies 2 and 3 with no server processing time: higher delay */
+	_bench_make_packet(pkt, 4, 2, 6);
+	memcpy(pkt + NTP_WIRE_OFF_ORIG_TM_S, orig2, 8);
+	memcpy(pkt + NTP_WIRE_OFF_RX_TM_S, pkt + NTP_WIRE_OFF_TX_TM_S, 8);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+	_bench_make_packet(pkt, 4, 2, 6);
+	memcpy(pkt + NTP_WIRE_OFF_ORIG_TM_S, orig3, 8);
+	memcpy(pkt + NTP_WIRE_OFF_RX_TM_S, pkt + NTP_WIRE_OFF_TX_TM_S, 8);
+	_bench_deliver(&client, pkt, false);
+	ntp_client_process(&client);
+
+	_bench_check(client.state == NTP_CLIENT_DONE,
+			"burst concluded when every reply was in");
+	_bench_check(_handler_calls == 1, "burst: one handler call");
+	_bench_check((client.delay < -50000) && (client.delay > -70000),
+			"burst selected the minimum-delay sample");
+	_bench_check(ot_stub_msgs_live == 0, "burst leaked no messages");
+	printf("trace, burst poll:          3 tx, best delay %lld us,"
+			" final state 0x%02x\n", (long long)client.delay,
+			client.state);
+}
+
+/* Persisted clock state round-trips and is flagged stale on restore */
+static void _bench_persist(void) {
+	struct ntp_clock_t clock;
+	struct timeval tv;
+	uint8_t page[NTP_PERSIST_SIZE];
+
+	ot_stub_reset();
+	ntp_clock_init(&clock);
+	tv.tv_sec = 1514764800;		/* An arbitrary known time */
+	tv.tv_usec = 250000;
+	_bench_check(ntp_clock_update(&clock, &tv) == OT_ERROR_NONE,
+			"clock accepts a sample");
+	_bench_check(ntp_persist_save(&clock, page, sizeof(page))
+				== OT_ERROR_NONE,
+			"persist save");
+
+	/* "Reboot": a fresh clock seeded from the page */
+	ntp_clock_init(&clock);
+	_bench_check(ntp_clock_now(&clock, &tv) == OT_ERROR_INVALID_STATE,
+			"unseeded clock has no time");
+	_bench_check(ntp_persist_restore(&clock, page, sizeof(page))
+				== OT_ERROR_NONE,
+			"persist restore");
+	_bench_check(clock.stale, "restored clock is stale");
+	ot_stub_advance_ms(2500);
+	_bench_check(ntp_clock_now(&clock, &tv) == OT_ERROR_NONE,
+			"restored clock reports time");
+	_bench_check(tv.tv_sec == (1514764800 + 2), "restored time tracks");
+
+	/* The next live sample steps the clock and clears the flag */
+	tv.tv_sec = 1514765000;
+	tv.tv_usec = 0;
+	_bench_check(ntp_clock_update(&clock, &tv) == OT_ERROR_NONE,
+			"restored clock accepts a live sample");
+	_bench_check(!clock.stale, "live sample clears stale");
+
+	/* Erased flash (or a corrupt page) is rejected */
+	memset(page, 0xff, sizeof(page));
+	_bench_check(ntp_persist_restore(&clock, page, sizeof(page))
+				== OT_ERROR_NOT_FOUND,
+			"erased page rejected");
+	printf("trace, persist/restore:     restored, stale until next"
+			" sample\n");
+}
+
+/* The server cache learns which server answers and selects it */
+static void _bench_servers(void) {
+	static struct ntp_server_cache_t cache;
+	static struct ntp_client_t client;
+	otIp6Address dead_addr;
+	const otIp6Address* best;
+	uint32_t n;
+
+	memcpy(&dead_addr, &_server_addr, sizeof(dead_addr));
+	dead_addr.mFields.m8[15] = 0x02;
+
+	ntp_server_cache_init(&cache);
+
+	/* A few polls of each: one answers in 20 ms, one never does */
+	for (n = 0; n < 4; n++) {
+		memset(&client, 0, sizeof(client));
+		memcpy(&(client.peer_addr), &_server_addr,
+				sizeof(otIp6Address));
+		client.state = NTP_CLIENT_DONE;
+		client.delay = 20000;
+		client.srv_stratum = 2;
+		_bench_check(ntp_server_cache_update(&cache, &client)
+					== OT_ERROR_NONE,
+				"cache update (reply)");
+
+		memset(&client, 0, sizeof(client));
+		memcpy(&(client.peer_addr), &dead_addr,
+				sizeof(otIp6Address));
+		client.state = NTP_CLIENT_TIMEOUT;
+		_bench_check(ntp_server_cache_update(&cache, &client)
+					== OT_ERROR_NONE,
+				"cache update (timeout)");
+	}
+
+	best = ntp_server_select(&cache);
+	_bench_check(best && !memcmp(best, &_server_addr,
+				sizeof(otIp6Address)),
+			"select prefers the answering server");
+	printf("trace, server cache:        answering server selected\n");
+}
+
+/* Manycast discovery locks onto the nearest responder */
+static void _bench_discover(void) {
+	static struct ntp_discover_t discover;
+	uint8_t pkt[NTP_WIRE_PACKET_SIZE];
+	otMessageInfo msg_info;
+	otIp6Address near_addr, far_addr, found;
+
+	/*
+	 * The near server answers at +80 ms but ~62 ms of that was its own
+	 * processing time (visible in its rx/tx stamps), net path ~18 ms.
+	 * The far server answers at +120 ms with zero processing time.
+	 * The near one must win.
+	 */
+	memcpy(&near_addr, &_server_addr, sizeof(near_addr));
+	near_addr.mFields.m8[15] = 0x11;
+	memcpy(&far_addr, &_server_addr, sizeof(far_addr));
+	far_addr.mFields.m8[15] = 0x22;
+
+	ot_stub_reset();
+	memset(&discover, 0, sizeof(discover));
+	_handler_calls = 0;
+	_bench_check(ntp_discover_begin(ot_stub_instance(), &discover,
+				&_mcast_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				0, NULL, NULL) == OT_ERROR_NONE,
+			"discover begin");
+	_bench_check(ot_stub_udp_sends == 1, "one probe transmitted");
+
+	memset(&msg_info, 0, sizeof(msg_info));
+	msg_info.mPeerPort = NTP_CLIENT_DEFAULT_PORT;
+
+	ot_stub_advance_ms(80);
+	_bench_make_packet(pkt, 4, 2, 6);
+	memcpy(&(msg_info.mPeerAddr), &near_addr, sizeof(otIp6Address));
+	ot_stub_deliver(&(discover.socket), pkt, NTP_WIRE_PACKET_SIZE,
+			&msg_info);
+
+	ot_stub_advance_ms(40);
+	_bench_make_packet(pkt, 4, 3, 6);
+	memcpy(pkt + NTP_WIRE_OFF_RX_TM_S, pkt + NTP_WIRE_OFF_TX_TM_S, 8);
+	memcpy(&(msg_info.mPeerAddr), &far_addr, sizeof(otIp6Address));
+	ot_stub_deliver(&(discover.socket), pkt, NTP_WIRE_PACKET_SIZE,
+			&msg_info);
+
+	/* Mid-window: no conclusion yet */
+	ntp_discover_process(&discover);
+	_bench_check(discover.state == NTP_CLIENT_SENT,
+			"window still open");
+
+	ot_stub_advance_ms(NTP_DISCOVER_WINDOW_MS);
+	ntp_discover_process(&discover);
+	_bench_check(discover.state == NTP_CLIENT_DONE,
+			"discovery concluded");
+	_bench_check(discover.responders == 2, "both responders counted");
+	_bench_check(ntp_discover_result(&discover, &found)
+				== OT_ERROR_NONE,
+			"discovery result available");
+	_bench_check(!memcmp(&found, &near_addr, sizeof(otIp6Address)),
+			"lowest net delay responder selected");
+	printf("trace, manycast discovery:  %u responders, best %u ms\n",
+			discover.responders, discover.best_delay_ms);
+}
+
+/* Multicast subscriptions are reference-counted and released on shutdown */
+static void _bench_mcast(void) {
+	static struct ntp_client_t c1, c2;
+	otIp6Address group;
+
+	/* A group of our own, untouched by the other sections */
+	memset(&group, 0, sizeof(group));
+	group.mFields.m8[0] = 0xff;
+	group.mFields.m8[1] = 0x02;
+	group.mFields.m8[15] = 0x42;
+
+	ot_stub_reset();
+	memset(&c1, 0, sizeof(c1));
+	memset(&c2, 0, sizeof(c2));
+
+	_bench_check(ntp_client_listen(ot_stub_instance(), &c1, &group,
+				NTP_CLIENT_DEFAULT_PORT, _bench_handler,
+				NULL) == OT_ERROR_NONE,
+			"listen (mcast c1)");
+	_bench_check(ot_stub_mcast_subscribes == 1,
+			"first listener subscribes the group");
+	_bench_check(ntp_client_listen(ot_stub_instance(), &c2, &group,
+				NTP_CLIENT_DEFAULT_PORT, _bench_handler,
+				NULL) == OT_ERROR_NONE,
+			"listen (mcast c2)");
+	_bench_check(ot_stub_mcast_subscribes == 1,
+			"second listener shares the subscription");
+
+	ntp_client_shutdown(&c1);
+	_bench_check(ot_stub_mcast_unsubscribes == 0,
+			"group held whilst a listener remains");
+	ntp_client_shutdown(&c2);
+	_bench_check(ot_stub_mcast_unsubscribes == 1,
+			"last listener releases the group");
+
+	/* A full listen/shutdown cycle leaves no subscription behind */
+	memset(&c1, 0, sizeof(c1));
+	_bench_check(ntp_client_listen(ot_stub_instance(), &c1, &group,
+				NTP_CLIENT_DEFAULT_PORT, _bench_handler,
+				NULL) == OT_ERROR_NONE,
+			"listen (mcast cycle)");
+	ntp_client_shutdown(&c1);
+	_bench_check((ot_stub_mcast_subscribes == 2)
+				&& (ot_stub_mcast_unsubscribes == 2),
+			"listen/shutdown cycles balance");
+	printf("trace, multicast groups:    %u subscribes, %u released\n",
+			ot_stub_mcast_subscribes, ot_stub_mcast_unsubscribes);
+}
+
+/* Broadcast windows report the median sample, out-voting stragglers */
+static void _bench_bc_filter(void) {
+	static struct ntp_client_t client;
+	uint8_t pkt[NTP_WIRE_PACKET_SIZE];
+	int64_t baseline, err;
+	uint8_t n;
+
+	/* Per-broadcast reporting first, to take a reference offset */
+	ot_stub_reset();
+	memset(&client, 0, sizeof(client));
+	_bench_check(ntp_client_listen(ot_stub_instance(), &client,
+				&_mcast_addr, NTP_CLIENT_DEFAULT_PORT,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"listen (bc filter baseline)");
+	_bench_make_packet(pkt, 5, 2, 6);
+	ntp_wire_put_u32(pkt, NTP_WIRE_OFF_TX_TM_S, 3800000000u);
+	_bench_deliver(&client, pkt, true);
+	ntp_client_process(&client);
+	baseline = client.offset;
+	ntp_client_shutdown(&client);
+
+	/*
+	 * A five-sample window where the last broadcast arrives 30 s stale.
+	 * Per-packet reporting would hand that sample to the handler as-is;
+	 * the median filter must out-vote it and report once.
+	 */
+	memset(&client, 0, sizeof(client));
+	_bench_check(ntp_client_listen(ot_stub_instance(), &client,
+				&_mcast_addr, NTP_CLIENT_DEFAULT_PORT,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"listen (bc filter)");
+	_bench_check(ntp_client_set_bc_window(&client, 5) == OT_ERROR_NONE,
+			"bc window configured");
+	_handler_calls = 0;
+	for (n = 0; n < 5; n++) {
+		_bench_make_packet(pkt, 5, 2, 6);
+		ntp_wire_put_u32(pkt, NTP_WIRE_OFF_TX_TM_S, (n == 4)
+				? (3800000000u - 30) : 3800000000u);
+		_bench_deliver(&client, pkt, true);
+		ntp_client_process(&client);
+		if (n < 4)
+			_bench_check(_handler_calls == 0,
+					"mid-window broadcasts accumulate");
+	}
+	_bench_check(_handler_calls == 1, "one handler call per window");
+	_bench_check(client.state == NTP_CLIENT_LISTEN,
+			"still listening after the window");
+
+	err = client.offset - baseline;
+	if (err < 0)
+		err = -err;
+	_bench_check(err < 1000000, "straggler out-voted by the median");
+	_bench_check((client.ts.tv_sec == client.tv.tv_sec)
+				&& ((client.ts.tv_nsec / 1000)
+					== client.tv.tv_usec),
+			"filtered timespec agrees with timeval");
+
+	/* The next window accumulates and reports independently */
+	for (n = 0; n < 5; n++) {
+		_bench_make_packet(pkt, 5, 2, 6);
+		ntp_wire_put_u32(pkt, NTP_WIRE_OFF_TX_TM_S, 3800000000u);
+		_bench_deliver(&client, pkt, true);
+		ntp_client_process(&client);
+	}
+	_bench_check(_handler_calls == 2, "second window reported once");
+	ntp_client_shutdown(&client);
+	printf("trace, broadcast window:    5 samples/report, straggler"
+			" rejected\n");
+}
+
+/* The timer wheel fires expired deadlines and re-arms retransmissions */
+static void _bench_wheel(void) {
+	static struct ntp_wheel_t wheel;
+	static struct ntp_client_t clients[8];
+	uint64_t t0;
+	uint32_t n;
+
+	ot_stub_reset();
+	memset(clients, 0, sizeof(clients));
+	ntp_wheel_init(&wheel);
+
+	/* Two pending polls with staggered timeouts */
+	ntp_client_set_timeout(&clients[0], 500);
+	ntp_client_set_timeout(&clients[1], 5000);
+	for (n = 0; n < 2; n++) {
+		_bench_check(ntp_client_begin(ot_stub_instance(),
+					&clients[n], &_server_addr,
+					NTP_CLIENT_DEFAULT_PORT, 64,
+					_bench_handler, NULL)
+					== OT_ERROR_NONE,
+				"begin (wheel)");
+		_bench_check(ntp_wheel_schedule(&wheel, &clients[n])
+					== OT_ERROR_NONE,
+				"wheel schedule");
+	}
+
+	ot_stub_advance_ms(600);
+	ntp_wheel_process(&wheel);
+	_bench_check(clients[0].state == NTP_CLIENT_TIMEOUT,
+			"wheel fired the 500 ms deadline");
+	_bench_check(clients[1].state == NTP_CLIENT_SENT,
+			"wheel left the 5 s deadline pending");
+	_bench_check(ntp_wheel_next_in(&wheel) <= 4400,
+			"wheel reports the next deadline");
+
+	ot_stub_advance_ms(4500);
+	ntp_wheel_process(&wheel);
+	_bench_check(clients[1].state == NTP_CLIENT_TIMEOUT,
+			"wheel fired the 5 s deadline");
+	_bench_check(ntp_wheel_next_in(&wheel) == UINT32_MAX,
+			"wheel drained");
+
+	/* A retransmitting client stays registered across the expiry */
+	memset(&clients[2], 0, sizeof(clients[2]));
+	ntp_client_set_timeout(&clients[2], 500);
+	ntp_client_set_retry(&clients[2], 1);
+	_bench_check(ntp_client_begin(ot_stub_instance(), &clients[2],
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL) == OT_ERROR_NONE,
+			"begin (wheel retry)");
+	ntp_wheel_schedule(&wheel, &clients[2]);
+	ot_stub_advance_ms(600);
+	ntp_wheel_process(&wheel);
+	_bench_check(clients[2].state == NTP_CLIENT_SENT,
+			"retransmission armed through the wheel");
+	_bench_check(ntp_wheel_next_in(&wheel) != UINT32_MAX,
+			"retransmission re-registered");
+	ntp_wheel_remove(&wheel, &clients[2]);
+	ntp_client_shutdown(&clients[2]);
+
+	/* Per-call cost with a handful of far-off deadlines registered */
+	memset(clients, 0, sizeof(clients));
+	ntp_wheel_init(&wheel);
+	for (n = 0; n < 8; n++) {
+		ntp_client_begin(ot_stub_instance(), &clients[n],
+				&_server_addr, NTP_CLIENT_DEFAULT_PORT, 64,
+				_bench_handler, NULL);
+		ntp_wheel_schedule(&wheel, &clients[n]);
+	}
+	t0 = _bench_now_ns();
+	for (n = 0; n < BENCH_ITERS_FAST; n++)
+		ntp_wheel_process(&wheel);
+	printf("wheel process, 8 pending:   %6.1f ns/call\n",
+			(double)(_bench_now_ns() - t0) / BENCH_ITERS_FAST);
+	printf("trace, timer wheel:         staggered deadlines fired in"
+			" order\n");
+}
+
+int main(void) {
+	_bench_addrs_init();
+
+	printf("== otntp host bench ==\n");
+	_bench_process_cost();
+	_bench_recv_cost();
+	_bench_exchange_cost();
+	_bench_traces();
+	_bench_burst();
+	_bench_persist();
+	_bench_servers();
+	_bench_discover();
+	_bench_mcast();
+	_bench_bc_filter();
+	_bench_wheel();
+
+	if (_failures) {
+		printf("== %d FAILURE(S) ==\n", _failures);
+		return 1;
+	}
+	printf("== all checks passed ==\n");
+	return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef _STUB_MACHINE_ENDIAN_H_
+#define _STUB_MACHINE_ENDIAN_H_
+#include <arpa/inet.h>
+#ifndef __ntohl
+#define __ntohl(x) ntohl(x)
+#endif
+#ifndef __htonl
+#define __htonl(x) htonl(x)
+#endif
+#ifndef __ntohs
+#define __ntohs(x) ntohs(x)
+#endif
+#ifndef __htons
+#define __htons(x) htons(x)
+#endif
+#endif
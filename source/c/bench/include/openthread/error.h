@@ -0,0 +1,17 @@
+#ifndef OPENTHREAD_ERROR_H_
+#define OPENTHREAD_ERROR_H_
+typedef enum otError {
+	OT_ERROR_NONE = 0,
+	OT_ERROR_FAILED = 1,
+	OT_ERROR_DROP = 2,
+	OT_ERROR_NO_BUFS = 3,
+	OT_ERROR_BUSY = 5,
+	OT_ERROR_PARSE = 6,
+	OT_ERROR_INVALID_ARGS = 7,
+	OT_ERROR_INVALID_STATE = 13,
+	OT_ERROR_NO_ACK = 14,
+	OT_ERROR_NOT_FOUND = 23,
+	OT_ERROR_ALREADY = 24,
+	OT_ERROR_RESPONSE_TIMEOUT = 28,
+} otError;
+#endif
@@ -0,0 +1,6 @@
+#ifndef OPENTHREAD_INSTANCE_H_
+#define OPENTHREAD_INSTANCE_H_
+#include <stdint.h>
+#include <openthread/error.h>
+typedef struct otInstance otInstance;
+#endif
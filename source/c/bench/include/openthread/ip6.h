@@ -0,0 +1,35 @@
+#ifndef OPENTHREAD_IP6_H_
+#define OPENTHREAD_IP6_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <openthread/instance.h>
+#include <openthread/message.h>
+
+typedef struct otIp6Address {
+	union {
+		uint8_t m8[16];
+		uint16_t m16[8];
+		uint32_t m32[4];
+	} mFields;
+} otIp6Address;
+
+typedef struct otSockAddr {
+	otIp6Address mAddress;
+	uint16_t mPort;
+	int8_t mScopeId;
+} otSockAddr;
+
+typedef struct otMessageInfo {
+	otIp6Address mSockAddr;
+	otIp6Address mPeerAddr;
+	uint16_t mSockPort;
+	uint16_t mPeerPort;
+	int8_t mInterfaceId;
+	uint8_t mHopLimit;
+	const void *mLinkInfo;
+} otMessageInfo;
+
+otError otIp6SubscribeMulticastAddress(otInstance *aInstance, const otIp6Address *aAddress);
+otError otIp6UnsubscribeMulticastAddress(otInstance *aInstance, const otIp6Address *aAddress);
+otError otIp6AddressFromString(const char *aString, otIp6Address *aAddress);
+#endif
@@ -0,0 +1,19 @@
+#ifndef OPENTHREAD_MESSAGE_H_
+#define OPENTHREAD_MESSAGE_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <openthread/instance.h>
+
+typedef struct otMessage otMessage;
+
+typedef struct otMessageSettings {
+	bool mLinkSecurityEnabled;
+	uint8_t mPriority;
+} otMessageSettings;
+
+void otMessageFree(otMessage *aMessage);
+uint16_t otMessageGetLength(const otMessage *aMessage);
+uint16_t otMessageGetOffset(const otMessage *aMessage);
+otError otMessageAppend(otMessage *aMessage, const void *aBuf, uint16_t aLength);
+uint16_t otMessageRead(const otMessage *aMessage, uint16_t aOffset, void *aBuf, uint16_t aLength);
+#endif
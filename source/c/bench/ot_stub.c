@@ -0,0 +1,214 @@
+/* vim: set noet tw=78 si: */
+/*!
+ * OpenThread NTP Client: host-side OpenThread stub
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+
+#include "ot_stub.h"
+#include <string.h>
+#include <openthread/message.h>
+#include <openthread/platform/alarm-milli.h>
+
+/*! Messages in the stub pool, mirroring a small OT buffer pool */
+#define OT_STUB_MSG_POOL	(8)
+
+/*! Bytes of payload a stub message can carry */
+#define OT_STUB_MSG_SIZE	(64)
+
+/*!
+ * Offset of the payload within a delivered message.  OpenThread hands the
+ * UDP callback a message whose offset points past the IPv6/UDP headers;
+ * keeping it non-zero here means any code that forgets to honour
+ * otMessageGetOffset() fails in the bench, not on the device.
+ */
+#define OT_STUB_MSG_OFFSET	(48)
+
+struct otMessage {
+	uint8_t		buf[OT_STUB_MSG_OFFSET + OT_STUB_MSG_SIZE];
+	uint16_t	length;
+	uint16_t	offset;
+	bool		used;
+};
+
+struct otInstance {
+	uint8_t		unused;
+};
+
+static struct otInstance _instance;
+static struct otMessage _msg_pool[OT_STUB_MSG_POOL];
+static uint32_t _now_ms;
+
+uint32_t ot_stub_udp_opens;
+uint32_t ot_stub_udp_closes;
+uint32_t ot_stub_udp_sends;
+uint32_t ot_stub_msgs_live;
+uint32_t ot_stub_msgs_fail;
+uint32_t ot_stub_mcast_subscribes;
+uint32_t ot_stub_mcast_unsubscribes;
+
+uint8_t ot_stub_last_tx[OT_STUB_MSG_SIZE];
+uint16_t ot_stub_last_tx_len;
+otUdpSocket* ot_stub_last_tx_socket;
+
+otInstance* ot_stub_instance(void) {
+	return &_instance;
+}
+
+void ot_stub_reset(void) {
+	memset(_msg_pool, 0, sizeof(_msg_pool));
+	memset(ot_stub_last_tx, 0, sizeof(ot_stub_last_tx));
+	_now_ms = 1000;
+	ot_stub_udp_opens = 0;
+	ot_stub_udp_closes = 0;
+	ot_stub_udp_sends = 0;
+	ot_stub_msgs_live = 0;
+	ot_stub_msgs_fail = 0;
+	ot_stub_mcast_subscribes = 0;
+	ot_stub_mcast_unsubscribes = 0;
+	ot_stub_last_tx_len = 0;
+	ot_stub_last_tx_socket = NULL;
+}
+
+void ot_stub_advance_ms(uint32_t ms) {
+	_now_ms += ms;
+}
+
+uint32_t otPlatAlarmMilliGetNow(void) {
+	return _now_ms;
+}
+
+/* Allocate a message from the pool, or NULL if exhausted */
+static struct otMessage* _ot_stub_msg_alloc(void) {
+	uint8_t idx;
+	for (idx = 0; idx < OT_STUB_MSG_POOL; idx++) {
+		if (!_msg_pool[idx].used) {
+			memset(&_msg_pool[idx], 0,
+					sizeof(struct otMessage));
+			_msg_pool[idx].used = true;
+			ot_stub_msgs_live++;
+			return &_msg_pool[idx];
+		}
+	}
+	return NULL;
+}
+
+otMessage* otUdpNewMessage(otInstance* aInstance,
+		const otMessageSettings* aSettings) {
+	(void)aInstance;
+	(void)aSettings;
+	if (ot_stub_msgs_fail) {
+		ot_stub_msgs_fail--;
+		return NULL;
+	}
+	return _ot_stub_msg_alloc();
+}
+
+void otMessageFree(otMessage* aMessage) {
+	if (aMessage && aMessage->used) {
+		aMessage->used = false;
+		ot_stub_msgs_live--;
+	}
+}
+
+uint16_t otMessageGetLength(const otMessage* aMessage) {
+	return aMessage->length;
+}
+
+uint16_t otMessageGetOffset(const otMessage* aMessage) {
+	return aMessage->offset;
+}
+
+otError otMessageAppend(otMessage* aMessage, const void* aBuf,
+		uint16_t aLength) {
+	if ((aMessage->length + aLength) > sizeof(aMessage->buf))
+		return OT_ERROR_NO_BUFS;
+	memcpy(aMessage->buf + aMessage->length, aBuf, aLength);
+	aMessage->length += aLength;
+	return OT_ERROR_NONE;
+}
+
+uint16_t otMessageRead(const otMessage* aMessage, uint16_t aOffset,
+		void* aBuf, uint16_t aLength) {
+	if (aOffset >= aMessage->length)
+		return 0;
+	if ((aOffset + aLength) > aMessage->length)
+		aLength = aMessage->length - aOffset;
+	memcpy(aBuf, aMessage->buf + aOffset, aLength);
+	return aLength;
+}
+
+otError otUdpOpen(otInstance* aInstance, otUdpSocket* aSocket,
+		otUdpReceive aCallback, void* aContext) {
+	(void)aInstance;
+	memset(aSocket, 0, sizeof(otUdpSocket));
+	aSocket->mHandler = aCallback;
+	aSocket->mContext = aContext;
+	ot_stub_udp_opens++;
+	return OT_ERROR_NONE;
+}
+
+otError otUdpClose(otUdpSocket* aSocket) {
+	(void)aSocket;
+	ot_stub_udp_closes++;
+	return OT_ERROR_NONE;
+}
+
+otError otUdpBind(otUdpSocket* aSocket, otSockAddr* aSockName) {
+	memcpy(&(aSocket->mSockName), aSockName, sizeof(otSockAddr));
+	return OT_ERROR_NONE;
+}
+
+otError otUdpSend(otUdpSocket* aSocket, otMessage* aMessage,
+		const otMessageInfo* aMessageInfo) {
+	(void)aMessageInfo;
+
+	uint16_t len = aMessage->length;
+	if (len > sizeof(ot_stub_last_tx))
+		len = sizeof(ot_stub_last_tx);
+	memcpy(ot_stub_last_tx, aMessage->buf, len);
+	ot_stub_last_tx_len = len;
+	ot_stub_last_tx_socket = aSocket;
+	ot_stub_udp_sends++;
+
+	/* The stack consumes the message on success */
+	otMessageFree(aMessage);
+	return OT_ERROR_NONE;
+}
+
+otError otIp6SubscribeMulticastAddress(otInstance* aInstance,
+		const otIp6Address* aAddress) {
+	(void)aInstance;
+	/* Treat unicast addresses the way OpenThread does */
+	if (aAddress->mFields.m8[0] != 0xff)
+		return OT_ERROR_INVALID_ARGS;
+	ot_stub_mcast_subscribes++;
+	return OT_ERROR_NONE;
+}
+
+otError otIp6UnsubscribeMulticastAddress(otInstance* aInstance,
+		const otIp6Address* aAddress) {
+	(void)aInstance;
+	if (aAddress->mFields.m8[0] != 0xff)
+		return OT_ERROR_INVALID_ARGS;
+	ot_stub_mcast_unsubscribes++;
+	return OT_ERROR_NONE;
+}
+
+void ot_stub_deliver(otUdpSocket* socket, const uint8_t* payload,
+		uint16_t len, const otMessageInfo* msg_info) {
+	if (!socket->mHandler)
+		return;
+
+	struct otMessage* msg = _ot_stub_msg_alloc();
+	if (!msg)
+		return;
+
+	if (len > OT_STUB_MSG_SIZE)
+		len = OT_STUB_MSG_SIZE;
+	memcpy(msg->buf + OT_STUB_MSG_OFFSET, payload, len);
+	msg->offset = OT_STUB_MSG_OFFSET;
+	msg->length = OT_STUB_MSG_OFFSET + len;
+
+	(socket->mHandler)(socket->mContext, msg, msg_info);
+	otMessageFree(msg);
+}
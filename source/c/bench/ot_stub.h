@@ -0,0 +1,65 @@
+/* vim: set tw=78 noet si sw=8 ts=8: */
+/*!
+ * OpenThread NTP Client: host-side OpenThread stub
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ *
+ * A minimal, deterministic implementation of the handful of OpenThread
+ * calls the client library uses, for building and exercising the state
+ * machine on a development host (`make bench`).  The millisecond clock is
+ * virtual and only moves when ot_stub_advance_ms() is called, so timeout
+ * and backoff behaviour can be scripted exactly.
+ */
+#ifndef _OT_STUB_H
+#define _OT_STUB_H
+
+#include <stdint.h>
+#include <openthread/instance.h>
+#include <openthread/ip6.h>
+#include <openthread/udp.h>
+
+/*! The single OpenThread instance the stub provides */
+otInstance* ot_stub_instance(void);
+
+/*! Reset the virtual clock, counters and message pool */
+void ot_stub_reset(void);
+
+/*! Advance the virtual millisecond clock (otPlatAlarmMilliGetNow()) */
+void ot_stub_advance_ms(uint32_t ms);
+
+/*! otUdpOpen() calls since the last reset */
+extern uint32_t ot_stub_udp_opens;
+/*! otUdpClose() calls since the last reset */
+extern uint32_t ot_stub_udp_closes;
+/*! Datagrams transmitted via otUdpSend() since the last reset */
+extern uint32_t ot_stub_udp_sends;
+/*! Messages currently allocated from the pool */
+extern uint32_t ot_stub_msgs_live;
+/*! Force the next N message allocations to fail (buffer pressure) */
+extern uint32_t ot_stub_msgs_fail;
+/*! otIp6SubscribeMulticastAddress() calls since the last reset */
+extern uint32_t ot_stub_mcast_subscribes;
+/*! otIp6UnsubscribeMulticastAddress() calls since the last reset */
+extern uint32_t ot_stub_mcast_unsubscribes;
+
+/*! Payload of the most recently transmitted datagram */
+extern uint8_t ot_stub_last_tx[64];
+/*! Length of the most recently transmitted datagram */
+extern uint16_t ot_stub_last_tx_len;
+/*! Socket the most recent datagram was transmitted on */
+extern otUdpSocket* ot_stub_last_tx_socket;
+
+/*!
+ * Deliver a datagram to a socket's receive callback, exactly as the
+ * OpenThread stack would: the payload is wrapped in a pool message (at a
+ * non-zero message offset, so offset arithmetic is exercised) and handed
+ * to the callback registered with otUdpOpen().
+ *
+ * @param[inout]	socket		Socket to deliver to
+ * @param[in]		payload		Datagram payload
+ * @param[in]		len		Payload length in bytes
+ * @param[in]		msg_info	Peer/local address information
+ */
+void ot_stub_deliver(otUdpSocket* socket, const uint8_t* payload,
+		uint16_t len, const otMessageInfo* msg_info);
+
+#endif
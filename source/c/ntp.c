@@ -9,27 +9,84 @@
  */
 
 #include "ntp.h"
+#include "ntp_priv.h"
+#include "ntp_wire.h"
+#include "ntp_mcast.h"
 #include <string.h>
 #include <machine/endian.h>
 #include <openthread/message.h>
+#include <openthread/platform/alarm-milli.h>
 
 #define NTP_TIMESTAMP_DELTA	(2208988800ull)
 
-/*!
- * NTP defines the fractional part as 1/2³² seconds or ~233 ps.
- * There are approximately 4295 fractional time units per microsecond.
- */
-#define NTP_TS_FRAC_PER_US	(4295)
-#define NTP_TIMEOUT		(300)		/*!< Timeout in 0.1 seconds */
+#define NTP_TIMEOUT_MS		(30000)		/*!< Timeout in milliseconds */
+
+/*! Floor for the adaptive reply timeout, in milliseconds */
+#define NTP_TIMEOUT_MIN_MS	(250)
+/*! The adaptive timeout is this multiple of the round-trip EWMA */
+#define NTP_TIMEOUT_RTT_MULT	(4)
+
+/*! Mode field value for a server reply */
+#define NTP_MODE_SERVER		(4)
+/*! Mode field value for a broadcast */
+#define NTP_MODE_BROADCAST	(5)
+/*! Highest valid stratum for a synchronised server */
+#define NTP_STRATUM_MAX		(15)
+
+/*! Initial backoff when a transmission is starved of buffers, in ms */
+#define NTP_SEND_RETRY_MIN_MS	(20)
+/*! Ceiling on the buffer-starvation backoff, in milliseconds */
+#define NTP_SEND_RETRY_MAX_MS	(1000)
+
+/*! Initial Kiss-o'-Death backoff, in seconds */
+#define NTP_KOD_BACKOFF_MIN_S	(64)
+/*! Ceiling on the Kiss-o'-Death backoff, in seconds */
+#define NTP_KOD_BACKOFF_MAX_S	(3600)
+/*! Largest poll-field exponent we will honour (2¹⁰ = 1024 s) */
+#define NTP_POLL_LOG2_MAX	(10)
+
+#if NTP_CLIENT_ENABLE_STATS
+/* Record a round-trip sample and the offset it produced */
+static void _ntp_client_stats_sample(struct ntp_client_t* const ntp_client,
+		uint32_t rtt_ms) {
+	struct ntp_client_stats_t* stats = &(ntp_client->stats);
+	if (!stats->rtt_min_ms || (rtt_ms < stats->rtt_min_ms))
+		stats->rtt_min_ms = rtt_ms;
+	if (rtt_ms > stats->rtt_max_ms)
+		stats->rtt_max_ms = rtt_ms;
+	stats->last_offset = ntp_client->offset;
+}
+#define NTP_STATS_INC(c, f)		((c)->stats.f++)
+#define NTP_STATS_SAMPLE(c, rtt)	_ntp_client_stats_sample((c), (rtt))
+#else
+#define NTP_STATS_INC(c, f)		do { } while (0)
+#define NTP_STATS_SAMPLE(c, rtt)	do { } while (0)
+#endif
 
 /* Forward declaration of reply handler */
 static void ntp_client_recv(
 		void *context, otMessage *msg,
 		const otMessageInfo *msg_info);
 
-/* Shutdown code, closes off socket or sets an error condition */
-static void _ntp_client_shutdown(struct ntp_client_t* const ntp_client) {
+/* Convert a host-order NTP time-stamp to microseconds since the UNIX epoch */
+static int64_t _ntp_ts_to_usec(uint32_t secs, uint32_t frac) {
+	return (((int64_t)secs - NTP_TIMESTAMP_DELTA) * 1000000ll)
+		+ (int64_t)ntp_frac_to_usec(frac);
+}
+
+/* Convert a struct timeval to microseconds since the UNIX epoch */
+static int64_t _ntp_tv_to_usec(const struct timeval* const tv) {
+	return ((int64_t)tv->tv_sec * 1000000ll) + (int64_t)tv->tv_usec;
+}
+
+/* Close the socket unconditionally, or set an error condition */
+static void _ntp_client_close(struct ntp_client_t* const ntp_client) {
+	if (!ntp_client->sock_open) {
+		return;
+	}
+
 	/* Close off the socket, we're done now */
+	ntp_client->sock_open = false;
 	ntp_client->error = otUdpClose(&(ntp_client->socket));
 	if (ntp_client->error != OT_ERROR_NONE) {
 		ntp_client->state = NTP_CLIENT_INT_ERR;
@@ -37,6 +94,27 @@ static void _ntp_client_shutdown(struct ntp_client_t* const ntp_client) {
 	}
 }
 
+/* True whilst a burst poll is in flight on this client */
+static inline bool _ntp_client_burst_active(
+		const struct ntp_client_t* const ntp_client) {
+	return (ntp_client->burst_count != 0);
+}
+
+/* Shutdown code, closes off socket or sets an error condition */
+static void _ntp_client_shutdown(struct ntp_client_t* const ntp_client) {
+	/*
+	 * Persistent clients hold their socket open between polls, as does
+	 * a burst still waiting on further replies; only an explicit
+	 * ntp_client_shutdown() (or the end of the burst) tears it down.
+	 */
+	if (ntp_client->persistent || _ntp_client_burst_active(ntp_client)) {
+		return;
+	}
+
+	_ntp_client_close(ntp_client);
+}
+
+#if NTP_CLIENT_ENABLE_LISTEN
 /*!
  * Listen for broadcast NTP time updates from an NTP server.
  *
@@ -72,17 +150,18 @@ otError ntp_client_listen(otInstance* instance,
 	/*
 	 * If multicast, ensure the multicast IP is added.  We don't know if
 	 * it's multicast (OpenThread won't tell us), but we can just try it.
+	 * The registry reference-counts the group, so the subscription is
+	 * released again when the last listener on it shuts down.
 	 */
-	ntp_client->error = otIp6SubscribeMulticastAddress(instance, addr);
+	memcpy(&(ntp_client->peer_addr), addr, sizeof(otIp6Address));
+	ntp_client->error = ntp_mcast_subscribe(instance, addr);
 	switch (ntp_client->error) {
 	case OT_ERROR_NONE:
-		/*
-		 * Okay, we're subscribed.
-		 * TODO: set flag to unsubscribe later
-		 */
+		/* Subscribed; release our reference on shutdown */
+		ntp_client->mcast_subscribed = true;
 		break;
 	case OT_ERROR_ALREADY:
-		/* Already unsubscribed, don't unsubscribe later. */
+		/* The application's subscription; leave it alone. */
 		break;
 	case OT_ERROR_INVALID_ARGS:
 		/* Not a multicast address?  We can ignore this. */
@@ -99,6 +178,7 @@ otError ntp_client_listen(otInstance* instance,
 			ntp_client_recv, (void*)ntp_client);
 	if (ntp_client->error != OT_ERROR_NONE)
 		return ntp_client->error;
+	ntp_client->sock_open = true;
 
 	otSockAddr sockaddr;
 	memset(&sockaddr, 0, sizeof(otSockAddr));
@@ -106,6 +186,10 @@ otError ntp_client_listen(otInstance* instance,
 	sockaddr.mPort = port;
 	ntp_client->error = otUdpBind(&(ntp_client->socket), &sockaddr);
 	if (ntp_client->error != OT_ERROR_NONE) {
+		if (ntp_client->mcast_subscribed) {
+			ntp_client->mcast_subscribed = false;
+			ntp_mcast_unsubscribe(instance, addr);
+		}
 		_ntp_client_shutdown(ntp_client);
 		return ntp_client->error;
 	}
@@ -114,95 +198,135 @@ otError ntp_client_listen(otInstance* instance,
 	ntp_client->state = NTP_CLIENT_LISTEN;
 	return ntp_client->error;
 }
+#endif /* NTP_CLIENT_ENABLE_LISTEN */
 
 /*!
  * Shutdown a listening client.
  * @param[inout]	ntp_client	NTP client instance
  */
 otError ntp_client_shutdown(struct ntp_client_t* const ntp_client) {
-	_ntp_client_shutdown(ntp_client);
+	ntp_client->persistent = false;
+#if NTP_CLIENT_ENABLE_LISTEN
+	if (ntp_client->mcast_subscribed) {
+		/* Release our reference on the listened-to group */
+		ntp_client->mcast_subscribed = false;
+		ntp_mcast_unsubscribe(ntp_client->instance,
+				&(ntp_client->peer_addr));
+	}
+#endif
+	_ntp_client_close(ntp_client);
 	if (!ntp_client_is_done(ntp_client)) {
 		ntp_client->state = NTP_CLIENT_DONE;
 	}
 	return ntp_client->error;
 }
 
-/*!
- * Initiate a poll of an NTP server.
- *
- * @param[inout]	instance	OpenThread instance to use for this
- * 					client's context.
- * @param[inout]	ntp_client	NTP client instance
- * @param[in]		addr		IPv6 address of NTP server
- * @param[in]		port		Port number of NTP server
- * @param[in]		ttl		Message time-to-live
+/*
+ * The reply timeout for the next transmission: adaptive (or explicitly
+ * configured), with exponential backoff across retransmissions.
  */
-otError ntp_client_begin(otInstance* instance,
-		struct ntp_client_t* const ntp_client,
-		const otIp6Address* addr, uint16_t port, uint8_t ttl,
-		ntp_client_event_handler_t handler,
-		void* handler_context) {
-	/* Validate inputs */
-	if (!instance)
-		return OT_ERROR_PARSE;
-	if (!ntp_client)
-		return OT_ERROR_PARSE;
-	if (ntp_client->state)
-		return OT_ERROR_ALREADY;
+static uint32_t _ntp_client_timeout_ms(
+		const struct ntp_client_t* const ntp_client) {
+	/*
+	 * Once we have a feel for the path's round-trip time, wait a small
+	 * multiple of that; the static timeout only bounds the first
+	 * exchange and pathological paths.
+	 */
+	uint32_t timeout_ms = NTP_TIMEOUT_MS;
+	uint32_t timeout_max_ms = NTP_TIMEOUT_MS;
+	if (ntp_client->timeout_ms) {
+		/* An explicitly configured timeout overrides all of that */
+		timeout_ms = ntp_client->timeout_ms;
+		if (timeout_max_ms < timeout_ms)
+			timeout_max_ms = timeout_ms;
+	} else if (ntp_client->rtt_ewma_ms) {
+		timeout_ms = ntp_client->rtt_ewma_ms
+				* NTP_TIMEOUT_RTT_MULT;
+		if (timeout_ms < NTP_TIMEOUT_MIN_MS)
+			timeout_ms = NTP_TIMEOUT_MIN_MS;
+	}
 
-	/* Create and zero out the state. */
-	memset(ntp_client, 0, sizeof(struct ntp_client_t));
+	/* Exponential backoff across retransmissions of this poll */
+	timeout_ms <<= ntp_client->retry_count;
+	if (timeout_ms > timeout_max_ms)
+		timeout_ms = timeout_max_ms;
 
-	/* Copy in the instance information */
-	ntp_client->instance = instance;
-	ntp_client->handler = handler;
-	ntp_client->handler_context = handler_context;
+	return timeout_ms;
+}
 
-	/*
-	 * Set the first byte's bits to 00,011,011 for li = 0, vn = 3, and
-	 * mode = 3. The rest will be left set to zero.
-	 */
-	ntp_client->packet.li = 0;
-	ntp_client->packet.vn = 3;
-	ntp_client->packet.mode = 3;
+/*
+ * Buffer pressure (OT_ERROR_NO_BUFS) starved a transmission: defer it
+ * and let ntp_client_process() re-attempt with backoff, instead of
+ * failing a scheduled poll because CoAP happened to be busy.  The
+ * overall reply timeout is armed on the first deferral, so a poll that
+ * never gets a buffer still concludes through the timeout path.
+ */
+static otError _ntp_client_send_defer(struct ntp_client_t* const ntp_client) {
+	uint32_t now = otPlatAlarmMilliGetNow();
 
-	/*
-	 * Create a UDP socket, connect to the server, send the packet.
-	 */
-	ntp_client->error = otUdpOpen(instance, &(ntp_client->socket),
-			ntp_client_recv, (void*)ntp_client);
-	if (ntp_client->error != OT_ERROR_NONE)
-		return ntp_client->error;
+	NTP_STATS_INC(ntp_client, no_bufs);
 
-	/*
-	 * Send it the NTP packet it wants.
-	 */
+	if (ntp_client->state != NTP_CLIENT_SEND_PEND) {
+		ntp_client->send_backoff_ms = NTP_SEND_RETRY_MIN_MS;
+		ntp_client->timeout_at = now
+				+ _ntp_client_timeout_ms(ntp_client);
+		ntp_client->state = NTP_CLIENT_SEND_PEND;
+	} else if (ntp_client->send_backoff_ms < NTP_SEND_RETRY_MAX_MS) {
+		ntp_client->send_backoff_ms <<= 1;
+		if (ntp_client->send_backoff_ms > NTP_SEND_RETRY_MAX_MS)
+			ntp_client->send_backoff_ms = NTP_SEND_RETRY_MAX_MS;
+	}
+
+	ntp_client->send_retry_at = now + ntp_client->send_backoff_ms;
+	ntp_client->error = OT_ERROR_NONE;
+	return ntp_client->error;
+}
 
+/*
+ * (Re)transmit the client's request to the stored peer.  The request is
+ * freshly time-stamped on each transmission.  Buffer starvation defers
+ * the attempt (see _ntp_client_send_defer()); any other failure closes
+ * the socket and lands the client in NTP_CLIENT_INT_ERR.
+ */
+static otError _ntp_client_send(struct ntp_client_t* const ntp_client) {
 	otMessageInfo msg_info;
 	otMessageSettings msgSettings;
 	msgSettings.mLinkSecurityEnabled = true;
 	msgSettings.mPriority = 0;
 
-	otMessage* msg = otUdpNewMessage(instance, &msgSettings);
+	otMessage* msg = otUdpNewMessage(ntp_client->instance,
+			&msgSettings);
 	if (!msg) {
-		/* Record new state */
-		ntp_client->state = NTP_CLIENT_INT_ERR;
-		ntp_client->error = OT_ERROR_NO_BUFS;
-
-		/* Close the socket */
-		otUdpClose(&(ntp_client->socket));
-		return ntp_client->error;
+		/* Out of buffers; try again shortly */
+		return _ntp_client_send_defer(ntp_client);
 	}
 
 	memset(&msg_info, 0, sizeof(otMessageInfo));
 	memcpy(&(msg_info.mPeerAddr),
-			addr, sizeof(otIp6Address));
-	msg_info.mPeerPort = port;
-	msg_info.mHopLimit = ttl;
+			&(ntp_client->peer_addr), sizeof(otIp6Address));
+	msg_info.mPeerPort = ntp_client->peer_port;
+	msg_info.mHopLimit = ntp_client->ttl;
+
+	/*
+	 * Build the request from the constant template — the only part
+	 * that varies between polls is the transmit time-stamp (T1 in RFC
+	 * 958 parlance).  The server echoes it back in the originate
+	 * time-stamp of its reply and we keep a local copy, both of which
+	 * feed the offset/delay computation when the reply arrives.
+	 */
+	uint8_t wire[NTP_WIRE_PACKET_SIZE];
+	memcpy(wire, ntp_wire_request, NTP_WIRE_PACKET_SIZE);
+
+	gettimeofday(&(ntp_client->tv_tx), NULL);
+	uint32_t tx_s = (uint32_t)(ntp_client->tv_tx.tv_sec
+			+ NTP_TIMESTAMP_DELTA);
+	uint32_t tx_f = ntp_usec_to_frac(
+			(uint32_t)ntp_client->tv_tx.tv_usec);
+	ntp_wire_put_u32(wire, NTP_WIRE_OFF_TX_TM_S, tx_s);
+	ntp_wire_put_u32(wire, NTP_WIRE_OFF_TX_TM_F, tx_f);
 
-	ntp_client->error = otMessageAppend(msg,
-			(const uint8_t*)(&(ntp_client->packet)),
-			sizeof(struct ntp_packet_t));
+	ntp_client->error = otMessageAppend(msg, wire,
+			NTP_WIRE_PACKET_SIZE);
 
 	if (ntp_client->error == OT_ERROR_NONE) {
 		/* No error, try sending */
@@ -214,56 +338,549 @@ otError ntp_client_begin(otInstance* instance,
 		/* Free message */
 		otMessageFree(msg);
 
+		if (ntp_client->error == OT_ERROR_NO_BUFS) {
+			/* Out of buffers; try again shortly */
+			return _ntp_client_send_defer(ntp_client);
+		}
+
 		/* Record new state */
 		ntp_client->state = NTP_CLIENT_INT_ERR;
 
 		/* Close the socket */
+		ntp_client->sock_open = false;
 		otUdpClose(&(ntp_client->socket));
 		return ntp_client->error;
 	}
 
-	/* Wait for the reply to come back */
+	NTP_STATS_INC(ntp_client, tx);
+
+	/*
+	 * Remember what left the wire: the receive path only accepts a
+	 * reply whose echoed originate time-stamp matches one of these.
+	 */
+	uint8_t slot = (uint8_t)(ntp_client->tx_stamp_head
+			& (NTP_CLIENT_TX_STAMPS - 1));
+	ntp_client->tx_stamps_s[slot] = tx_s;
+	ntp_client->tx_stamps_f[slot] = tx_f;
+	ntp_client->tx_stamp_head++;
 
-	ntp_client->timeout = NTP_TIMEOUT;
+	/*
+	 * Wait for the reply to come back.  A transmission that was
+	 * deferred under buffer pressure already armed the timeout on the
+	 * first deferral; don't push it out further.
+	 */
+	if (ntp_client->state != NTP_CLIENT_SEND_PEND) {
+		ntp_client->timeout_at = otPlatAlarmMilliGetNow()
+				+ _ntp_client_timeout_ms(ntp_client);
+	}
 	ntp_client->state = NTP_CLIENT_SENT;
 	return ntp_client->error;
 }
 
+/*
+ * Common implementation behind ntp_client_begin and
+ * ntp_client_begin_persistent.  A persistent client whose socket is still
+ * open from a previous completed poll skips the otUdpOpen()/otUdpClose()
+ * cycle and re-uses the socket.
+ */
+static otError _ntp_client_begin(otInstance* instance,
+		struct ntp_client_t* const ntp_client,
+		const otIp6Address* addr, uint16_t port, uint8_t ttl,
+		ntp_client_event_handler_t handler,
+		void* handler_context,
+		bool persistent) {
+	/* Validate inputs */
+	if (!instance)
+		return OT_ERROR_PARSE;
+	if (!ntp_client)
+		return OT_ERROR_PARSE;
+
+	/*
+	 * A persistent client that has finished its previous poll may be
+	 * re-used with its socket still open.
+	 */
+	bool reuse = persistent && ntp_client->persistent
+			&& ntp_client->sock_open
+			&& ntp_client_is_done(ntp_client);
+
+	/*
+	 * A client whose previous poll has concluded (any final state) may
+	 * be re-begun; one still in flight may not.
+	 */
+	if (ntp_client->state && !ntp_client_is_done(ntp_client) && !reuse)
+		return OT_ERROR_ALREADY;
+
+	/* Self-throttle: honour the server's rate limits */
+	if (ntp_client->poll_not_before
+			&& !_ntp_ms_reached(otPlatAlarmMilliGetNow(),
+				ntp_client->poll_not_before))
+		return OT_ERROR_BUSY;
+
+	if (reuse) {
+		/* Reset per-poll state, keep the open socket. */
+		ntp_client->error = OT_ERROR_NONE;
+		ntp_client->state = NTP_CLIENT_INIT;
+		ntp_client->ev_tail = ntp_client->ev_head;
+		ntp_client->retry_count = 0;
+
+		/*
+		 * The origin check must not honour the previous poll's
+		 * transmit stamps, or a delayed or replayed reply to the
+		 * last exchange could conclude this one.
+		 */
+		memset(ntp_client->tx_stamps_s, 0,
+				sizeof(ntp_client->tx_stamps_s));
+		memset(ntp_client->tx_stamps_f, 0,
+				sizeof(ntp_client->tx_stamps_f));
+		ntp_client->tx_stamp_head = 0;
+	} else {
+		/*
+		 * A concluded persistent client re-begun without reuse still
+		 * holds its socket open.  Close it before the state is
+		 * wiped: zeroing a registered otUdpSocket would truncate the
+		 * stack's UDP socket list, and re-opening it would insert
+		 * the node twice.
+		 */
+		if (ntp_client->sock_open)
+			_ntp_client_close(ntp_client);
+
+		/*
+		 * Create and zero out the state, carrying the round-trip
+		 * EWMA, retry policy and statistics over from any previous
+		 * poll of this client.
+		 */
+		uint32_t rtt_ewma_ms = ntp_client->rtt_ewma_ms;
+		uint32_t timeout_ms = ntp_client->timeout_ms;
+		uint8_t retry_max = ntp_client->retry_max;
+		uint32_t kiss_code = ntp_client->kiss_code;
+		uint16_t min_poll_s = ntp_client->min_poll_s;
+		uint16_t kod_backoff_s = ntp_client->kod_backoff_s;
+		uint32_t poll_not_before = ntp_client->poll_not_before;
+#if NTP_CLIENT_ENABLE_STATS
+		struct ntp_client_stats_t stats = ntp_client->stats;
+#endif
+		memset(ntp_client, 0, sizeof(struct ntp_client_t));
+		ntp_client->rtt_ewma_ms = rtt_ewma_ms;
+		ntp_client->timeout_ms = timeout_ms;
+		ntp_client->retry_max = retry_max;
+		ntp_client->kiss_code = kiss_code;
+		ntp_client->min_poll_s = min_poll_s;
+		ntp_client->kod_backoff_s = kod_backoff_s;
+		ntp_client->poll_not_before = poll_not_before;
+#if NTP_CLIENT_ENABLE_STATS
+		ntp_client->stats = stats;
+#endif
+	}
+
+	/* Copy in the instance information */
+	ntp_client->instance = instance;
+	ntp_client->handler = handler;
+	ntp_client->handler_context = handler_context;
+	ntp_client->persistent = persistent;
+
+	/* Remember the peer for (re)transmission */
+	memcpy(&(ntp_client->peer_addr), addr, sizeof(otIp6Address));
+	ntp_client->peer_port = port;
+	ntp_client->ttl = ttl;
+
+	/*
+	 * Create a UDP socket, connect to the server, send the packet.
+	 */
+	if (!reuse) {
+		ntp_client->error = otUdpOpen(instance,
+				&(ntp_client->socket),
+				ntp_client_recv, (void*)ntp_client);
+		if (ntp_client->error != OT_ERROR_NONE)
+			return ntp_client->error;
+		ntp_client->sock_open = true;
+	}
+
+	/*
+	 * Send it the NTP packet it wants.
+	 */
+	return _ntp_client_send(ntp_client);
+}
+
+/*!
+ * Initiate a poll of an NTP server.
+ *
+ * @param[inout]	instance	OpenThread instance to use for this
+ * 					client's context.
+ * @param[inout]	ntp_client	NTP client instance
+ * @param[in]		addr		IPv6 address of NTP server
+ * @param[in]		port		Port number of NTP server
+ * @param[in]		ttl		Message time-to-live
+ */
+otError ntp_client_begin(otInstance* instance,
+		struct ntp_client_t* const ntp_client,
+		const otIp6Address* addr, uint16_t port, uint8_t ttl,
+		ntp_client_event_handler_t handler,
+		void* handler_context) {
+	return _ntp_client_begin(instance, ntp_client, addr, port, ttl,
+			handler, handler_context, false);
+}
+
+/*!
+ * Initiate a poll of an NTP server, keeping the socket open for re-use
+ * by subsequent polls.
+ *
+ * @param[inout]	instance	OpenThread instance to use for this
+ * 					client's context.
+ * @param[inout]	ntp_client	NTP client instance
+ * @param[in]		addr		IPv6 address of NTP server
+ * @param[in]		port		Port number of NTP server
+ * @param[in]		ttl		Message time-to-live
+ */
+otError ntp_client_begin_persistent(otInstance* instance,
+		struct ntp_client_t* const ntp_client,
+		const otIp6Address* addr, uint16_t port, uint8_t ttl,
+		ntp_client_event_handler_t handler,
+		void* handler_context) {
+	return _ntp_client_begin(instance, ntp_client, addr, port, ttl,
+			handler, handler_context, true);
+}
+
+/*!
+ * Poll an NTP server with a burst of requests and report the single
+ * sample with the lowest round-trip delay.
+ *
+ * @param[inout]	instance	OpenThread instance to use for this
+ * 					client's context.
+ * @param[inout]	ntp_client	NTP client instance
+ * @param[in]		addr		IPv6 address of NTP server
+ * @param[in]		port		Port number of NTP server
+ * @param[in]		ttl		Message time-to-live
+ * @param[in]		count		Requests per burst
+ * @param[in]		interval_ms	Spacing between requests
+ */
+otError ntp_client_begin_burst(otInstance* instance,
+		struct ntp_client_t* const ntp_client,
+		const otIp6Address* addr, uint16_t port,
+		uint8_t ttl, uint8_t count, uint16_t interval_ms,
+		ntp_client_event_handler_t handler,
+		void* handler_context) {
+	if (!count || (count > NTP_CLIENT_BURST_MAX))
+		return OT_ERROR_INVALID_ARGS;
+	if (!interval_ms)
+		interval_ms = NTP_CLIENT_BURST_INTERVAL_MS;
+
+	otError error = _ntp_client_begin(instance, ntp_client, addr,
+			port, ttl, handler, handler_context, false);
+	if (error != OT_ERROR_NONE)
+		return error;
+
+	/*
+	 * The first request is already in flight; arm the burst schedule
+	 * for the remainder.  These fields are only read from the process
+	 * loop, so setting them after the send is safe.
+	 */
+	ntp_client->burst_count = count;
+	ntp_client->burst_sent = 1;
+	ntp_client->burst_recv = 0;
+	ntp_client->burst_interval_ms = interval_ms;
+	ntp_client->burst_next_at = otPlatAlarmMilliGetNow()
+			+ interval_ms;
+	return error;
+}
+
 /*!
- * Handler of incoming message, just dumps the payload into the local
- * buffer for use later.
+ * Handler of incoming message, captures the reply's time-stamp block
+ * into the local sample buffer for use later.
  */
 static void ntp_client_recv(
 		void* context, otMessage* msg,
 		const otMessageInfo* msg_info) {
 	(void)msg_info;
 
+	/* Time-stamp the arrival before doing anything else */
+	uint32_t rx_ms = otPlatAlarmMilliGetNow();
+
 	struct ntp_client_t* ntp_client = (struct ntp_client_t*)context;
 
+#if NTP_CLIENT_ENABLE_LISTEN
 	if ((ntp_client->state != NTP_CLIENT_SENT)
+			&& (ntp_client->state != NTP_CLIENT_SEND_PEND)
 			&& (ntp_client->state != NTP_CLIENT_LISTEN)) {
 		/* Invalid state, do nothing */
 		return;
 	}
+#else
+	if ((ntp_client->state != NTP_CLIENT_SENT)
+			&& (ntp_client->state != NTP_CLIENT_SEND_PEND)) {
+		/* Invalid state, do nothing */
+		return;
+	}
+#endif
 
-	uint16_t recv = otMessageRead(msg, otMessageGetOffset(msg),
-			(uint8_t*)(&(ntp_client->packet)),
-			sizeof(struct ntp_packet_t));
-	if (recv < sizeof(struct ntp_packet_t)) {
-		ntp_client->state = (ntp_client->state == NTP_CLIENT_SENT)
-				? NTP_CLIENT_ERR_TRUNC
-				: NTP_CLIENT_ERR_BC_TRUNC;
+	/*
+	 * Cheap sanity checks on the header bytes before anything else is
+	 * copied: the packet must be a server reply or broadcast from a
+	 * synchronised server.  A looped-back client request, a stratum-0
+	 * kiss-of-death or plain junk on port 123 is dropped right here,
+	 * before it can reach the state machine or the handler.
+	 */
+	uint16_t offset = otMessageGetOffset(msg);
+	uint8_t hdr[4];
+	if (otMessageRead(msg, offset, hdr, sizeof(hdr)) < sizeof(hdr)) {
+		/* Too short to even carry a header, drop it */
+		return;
+	}
+
+	uint8_t mode = hdr[0] & 0x07;
+#if NTP_CLIENT_ENABLE_LISTEN
+	if ((mode != NTP_MODE_SERVER) && (mode != NTP_MODE_BROADCAST)) {
+		return;
+	}
+#else
+	if (mode != NTP_MODE_SERVER) {
+		return;
+	}
+#endif
+
+	uint8_t stratum = hdr[1];
+	if (!stratum && (mode == NTP_MODE_SERVER)
+			&& (ntp_client->state != NTP_CLIENT_LISTEN)) {
+		/*
+		 * Stratum 0 in a direct reply is a Kiss-o'-Death.  Record
+		 * the kiss code and back off hard — servers send RATE
+		 * precisely because clients keep hammering them, and each
+		 * refused exchange otherwise ends in a timeout stall.
+		 */
+		otMessageRead(msg, offset + NTP_WIRE_OFF_REF_ID,
+				(uint8_t*)(&(ntp_client->kiss_code)),
+				sizeof(ntp_client->kiss_code));
+
+		uint32_t backoff_s = ntp_client->kod_backoff_s
+				? ((uint32_t)ntp_client->kod_backoff_s * 2)
+				: NTP_KOD_BACKOFF_MIN_S;
+		if (backoff_s > NTP_KOD_BACKOFF_MAX_S)
+			backoff_s = NTP_KOD_BACKOFF_MAX_S;
+		if (backoff_s < ntp_client->min_poll_s)
+			backoff_s = ntp_client->min_poll_s;
+		ntp_client->kod_backoff_s = (uint16_t)backoff_s;
+		ntp_client->poll_not_before = rx_ms + (backoff_s * 1000);
+
+		ntp_client->state = NTP_CLIENT_ERR_KOD;
+		return;
+	}
+	if ((stratum < 1) || (stratum > NTP_STRATUM_MAX)) {
+		return;
+	}
+
+	/*
+	 * Reserve a slot in the event ring; if a burst has filled it
+	 * faster than the main loop drains it, the newest packet is the
+	 * one we drop.
+	 */
+	uint8_t head = ntp_client->ev_head;
+	uint8_t next = (head + 1) & (NTP_CLIENT_EVENT_RING - 1);
+	if (next == ntp_client->ev_tail) {
+		return;
+	}
+	struct ntp_client_event_t* ev = &(ntp_client->events[head]);
+
+	/*
+	 * Read only the time-stamp block out of the message, at its fixed
+	 * offset within the packet.  This avoids copying the full 48 bytes
+	 * per datagram and leaves our own request packet intact.
+	 */
+	uint16_t recv = otMessageRead(msg,
+			offset + NTP_WIRE_OFF_ORIG_TM_S,
+			(uint8_t*)(&(ev->sample)),
+			sizeof(struct ntp_sample_t));
+	if ((recv < sizeof(struct ntp_sample_t))
+			|| ((otMessageGetLength(msg) - offset)
+				< NTP_WIRE_PACKET_SIZE)) {
+		if (ntp_client->state != NTP_CLIENT_LISTEN) {
+			NTP_STATS_INC(ntp_client, trunc);
+			ntp_client->state = NTP_CLIENT_ERR_TRUNC;
+		}
+#if NTP_CLIENT_ENABLE_LISTEN
+		else {
+			NTP_STATS_INC(ntp_client, bc_trunc);
+			ntp_client->state = NTP_CLIENT_ERR_BC_TRUNC;
+		}
+#endif
+	} else if (!ev->sample.txTm_s) {
+		/*
+		 * A server that has never set its clock transmits a zero
+		 * time-stamp; that is not a time we want.  Keep waiting.
+		 */
+		return;
 	} else {
-		ntp_client->state = (ntp_client->state == NTP_CLIENT_SENT)
-				? NTP_CLIENT_RECV
-				: NTP_CLIENT_RECV_BC;
+#if NTP_CLIENT_ENABLE_LISTEN
+		if (ntp_client->state != NTP_CLIENT_LISTEN) {
+#endif
+			/*
+			 * The origin check (RFC 5905 §8): a direct reply must
+			 * echo the transmit time-stamp of one of this poll's
+			 * requests, or it is not an answer to anything we
+			 * asked — a duplicate, a stray, or a spoof.  Matching
+			 * against the whole ring (not just the latest
+			 * transmission) keeps late replies to earlier burst
+			 * requests and retransmissions acceptable.
+			 */
+			uint32_t orig_s = __ntohl(ev->sample.origTm_s);
+			uint32_t orig_f = __ntohl(ev->sample.origTm_f);
+			uint8_t i;
+			for (i = 0; i < NTP_CLIENT_TX_STAMPS; i++) {
+				if (orig_s
+					&& (ntp_client->tx_stamps_s[i]
+						== orig_s)
+					&& (ntp_client->tx_stamps_f[i]
+						== orig_f))
+					break;
+			}
+			if (i >= NTP_CLIENT_TX_STAMPS) {
+				NTP_STATS_INC(ntp_client, bad_orig);
+				return;
+			}
+#if NTP_CLIENT_ENABLE_LISTEN
+		}
+#endif
+
+		/*
+		 * Grab the root delay/dispersion words too; they size the
+		 * error budget that schedules the next poll.
+		 */
+		otMessageRead(msg, offset + NTP_WIRE_OFF_ROOT_DELAY,
+				(uint8_t*)(&(ev->root_delay)),
+				sizeof(ev->root_delay));
+		otMessageRead(msg, offset + NTP_WIRE_OFF_ROOT_DISP,
+				(uint8_t*)(&(ev->root_disp)),
+				sizeof(ev->root_disp));
+
+		/* Publish the event; the slot is filled in already. */
+		ev->rx_ms = rx_ms;
+		ev->srv_poll = hdr[2];
+		ev->srv_stratum = stratum;
+#if NTP_CLIENT_ENABLE_LISTEN
+		ev->bc = (ntp_client->state == NTP_CLIENT_LISTEN);
+#endif
+		ntp_client->ev_head = next;
+	}
+}
+
+/*!
+ * Deliver a received message to a client exactly as if it had arrived on
+ * the client's own socket.
+ */
+void _ntp_client_deliver(struct ntp_client_t* const ntp_client,
+		otMessage* msg, const otMessageInfo* msg_info) {
+	ntp_client_recv((void*)ntp_client, msg, msg_info);
+}
+
+/*
+ * Dequeue the oldest received event into the client's sample buffer and
+ * enter the matching receive state.  Returns false if the ring is empty.
+ */
+static bool _ntp_client_pop_event(struct ntp_client_t* const ntp_client) {
+	uint8_t tail = ntp_client->ev_tail;
+	if (tail == ntp_client->ev_head) {
+		return false;
 	}
+
+	const struct ntp_client_event_t* ev = &(ntp_client->events[tail]);
+	ntp_client->sample = ev->sample;
+	ntp_client->sample_rx_ms = ev->rx_ms;
+	ntp_client->srv_poll = ev->srv_poll;
+	ntp_client->srv_stratum = ev->srv_stratum;
+	ntp_client->root_delay = ev->root_delay;
+	ntp_client->root_disp = ev->root_disp;
+#if NTP_CLIENT_ENABLE_LISTEN
+	ntp_client->state = ev->bc ? NTP_CLIENT_RECV_BC : NTP_CLIENT_RECV;
+#else
+	ntp_client->state = NTP_CLIENT_RECV;
+#endif
+	ntp_client->ev_tail = (tail + 1) & (NTP_CLIENT_EVENT_RING - 1);
+	return true;
 }
 
+/*
+ * Conclude a burst poll: surface the lowest-delay sample as the client's
+ * result, invoke the handler once, and tear down (unless persistent).
+ */
+static void _ntp_client_burst_finish(struct ntp_client_t* const ntp_client) {
+	/* The burst is over; let the shutdown path see that */
+	ntp_client->burst_count = 0;
+
+	ntp_client->offset = ntp_client->best_offset;
+	ntp_client->delay = ntp_client->best_delay;
+	ntp_client->tv = ntp_client->best_tv;
+	ntp_client->ts = ntp_client->best_ts;
+
+	_ntp_client_shutdown(ntp_client);
+	if (ntp_client_is_done(ntp_client)) {
+		return;
+	}
+
+	ntp_client->state = NTP_CLIENT_RECV;
+
+	/* If there's a handler, call it now */
+	if (ntp_client->handler) {
+		(ntp_client->handler)(ntp_client);
+	}
+
+	ntp_client->state = NTP_CLIENT_DONE;
+}
+
+#if NTP_CLIENT_ENABLE_LISTEN
+/*
+ * Conclude a broadcast window: reduce the accumulated offsets to their
+ * median and shift the published result (computed from the final packet
+ * of the window) onto it.  If the final packet itself was the straggler,
+ * its error relative to the median is subtracted back out of `tv`/`ts`,
+ * so the reported time is the one the window voted for.
+ */
+static void _ntp_client_bc_filter(struct ntp_client_t* const ntp_client) {
+	int64_t sorted[NTP_CLIENT_BC_WINDOW_MAX];
+	uint8_t n = ntp_client->bc_fill;
+	uint8_t i, j;
+
+	/* Insertion sort; the window is at most 8 entries */
+	for (i = 0; i < n; i++) {
+		int64_t v = ntp_client->bc_offsets[i];
+		for (j = i; j && (sorted[j - 1] > v); j--)
+			sorted[j] = sorted[j - 1];
+		sorted[j] = v;
+	}
+
+	int64_t median = (n & 1)
+			? sorted[n / 2]
+			: ((sorted[(n / 2) - 1] + sorted[n / 2]) / 2);
+	int64_t adj = ntp_client->offset - median;
+
+	int64_t usec = _ntp_tv_to_usec(&(ntp_client->tv)) - adj;
+	ntp_client->tv.tv_sec = (time_t)(usec / 1000000);
+	ntp_client->tv.tv_usec = (uint32_t)(usec % 1000000);
+
+	int64_t nsec = ((int64_t)ntp_client->ts.tv_sec * 1000000000ll)
+			+ ntp_client->ts.tv_nsec - (adj * 1000);
+	ntp_client->ts.tv_sec = (time_t)(nsec / 1000000000ll);
+	ntp_client->ts.tv_nsec = (uint32_t)(nsec % 1000000000ll);
+
+	ntp_client->offset = median;
+	ntp_client->bc_fill = 0;
+}
+#endif /* NTP_CLIENT_ENABLE_LISTEN */
+
 /*!
  * Handling of received data.
  */
 static void ntp_client_recv_done(struct ntp_client_t* const ntp_client) {
+	struct timeval tv_rx;
+	gettimeofday(&tv_rx, NULL);
+
+	/*
+	 * The packet actually arrived when the receive callback stamped
+	 * sample_rx_ms, which may be well before this call — the main loop
+	 * runs when it runs.  Everything below backs its arithmetic off by
+	 * the interval the event spent queued, so sync accuracy does not
+	 * depend on main-loop scheduling latency.
+	 */
+	uint32_t queued_ms = otPlatAlarmMilliGetNow()
+			- ntp_client->sample_rx_ms;
+
 	if (ntp_client->state == NTP_CLIENT_RECV) {
 		/* Close off the socket, we're done now */
 		_ntp_client_shutdown(ntp_client);
@@ -279,8 +896,96 @@ static void ntp_client_recv_done(struct ntp_client_t* const ntp_client) {
 	 * network's to host's "endianness".
 	 */
 
-	ntp_client->packet.txTm_s = __ntohl( ntp_client->packet.txTm_s );
-	ntp_client->packet.txTm_f = __ntohl( ntp_client->packet.txTm_f );
+	/*
+	 * Size the error bound of this sync from the server's root delay
+	 * and dispersion (NTP short format, 2^-16 s units): how far off the
+	 * server itself may be, as of right now.  Local drift grows it from
+	 * here; ntp_client_next_poll_in() spends that budget.
+	 */
+	uint64_t root_delay_us = ((uint64_t)__ntohl(ntp_client->root_delay)
+			* 1000000ull) >> 16;
+	uint64_t root_disp_us = ((uint64_t)__ntohl(ntp_client->root_disp)
+			* 1000000ull) >> 16;
+	uint64_t err_us = root_disp_us + (root_delay_us / 2);
+	if (!err_us)
+		err_us = 1;	/* 0 is reserved for "never synced" */
+	ntp_client->sync_err_usec = (err_us > UINT32_MAX)
+			? UINT32_MAX : (uint32_t)err_us;
+
+	uint32_t txTm_s = __ntohl( ntp_client->sample.txTm_s );
+	uint32_t txTm_f = __ntohl( ntp_client->sample.txTm_f );
+	uint32_t rxTm_s = __ntohl( ntp_client->sample.rxTm_s );
+	uint32_t rxTm_f = __ntohl( ntp_client->sample.rxTm_f );
+
+	/*
+	 * Standard NTP offset/delay computation (RFC 958): T1 is the time
+	 * the request left us, T2 the time it reached the server, T3 the
+	 * time the reply left the server and T4 the time the reply reached
+	 * us.  T1 and T4 are on our clock, T2 and T3 on the server's, so
+	 * the symmetric-path assumption cancels the one-way latency out of
+	 * the offset.
+	 */
+	int64_t t3 = _ntp_ts_to_usec(txTm_s, txTm_f);
+	int64_t t4 = _ntp_tv_to_usec(&tv_rx)
+			- ((int64_t)queued_ms * 1000);
+
+	if (ntp_client->state == NTP_CLIENT_RECV) {
+		/*
+		 * T1 comes from the reply's echoed originate time-stamp, not
+		 * from tv_tx: tv_tx is re-stamped by every retransmission and
+		 * burst request, so a reply landing after the next request
+		 * went out would otherwise be scored against the wrong T1 —
+		 * skewing the offset and driving the delay negative, which
+		 * the burst minimum-delay selection would then prefer.  The
+		 * receive callback has already verified the echo matches one
+		 * of this poll's transmissions.
+		 */
+		int64_t t1 = _ntp_ts_to_usec(
+				__ntohl(ntp_client->sample.origTm_s),
+				__ntohl(ntp_client->sample.origTm_f));
+		int64_t t2 = _ntp_ts_to_usec(rxTm_s, rxTm_f);
+		ntp_client->offset = ((t2 - t1) + (t3 - t4)) / 2;
+		ntp_client->delay = (t4 - t1) - (t3 - t2);
+		NTP_STATS_INC(ntp_client, rx);
+
+		/* Fold the measured round trip into the EWMA (α = ¼) */
+		if (ntp_client->delay >= 0) {
+			uint32_t rtt_ms = (uint32_t)(
+					ntp_client->delay / 1000);
+			if (!rtt_ms)
+				rtt_ms = 1;
+			ntp_client->rtt_ewma_ms = ntp_client->rtt_ewma_ms
+				? (((3 * ntp_client->rtt_ewma_ms)
+						+ rtt_ms) / 4)
+				: rtt_ms;
+			NTP_STATS_SAMPLE(ntp_client, rtt_ms);
+		}
+
+		/*
+		 * The exchange succeeded, so any Kiss-o'-Death backoff is
+		 * lifted; the server's advertised poll field (log₂
+		 * seconds) still sets the floor on our next poll.
+		 */
+		uint8_t poll = ntp_client->srv_poll;
+		if (poll > NTP_POLL_LOG2_MAX)
+			poll = NTP_POLL_LOG2_MAX;
+		ntp_client->min_poll_s = (uint16_t)((uint32_t)1 << poll);
+		ntp_client->kod_backoff_s = 0;
+		ntp_client->poll_not_before = otPlatAlarmMilliGetNow()
+				+ ((uint32_t)ntp_client->min_poll_s
+					* 1000);
+	}
+#if NTP_CLIENT_ENABLE_LISTEN
+	else {
+		/*
+		 * Broadcast: there is no round trip to measure, the best we
+		 * can report is the raw one-way difference.
+		 */
+		ntp_client->offset = t3 - t4;
+		ntp_client->delay = 0;
+		NTP_STATS_INC(ntp_client, rx_bc);
+	}
+#endif
 
 	/*
 	 * Extract the 32 bits that represent the time-stamp seconds
@@ -290,16 +995,86 @@ static void ntp_client_recv_done(struct ntp_client_t* const ntp_client) {
 	 * This leaves the seconds since the UNIX epoch of 1970.
 	 */
 
-	ntp_client->tv.tv_sec = (time_t)(
-			ntp_client->packet.txTm_s
-			- NTP_TIMESTAMP_DELTA);
+	ntp_client->tv.tv_sec = (time_t)(txTm_s - NTP_TIMESTAMP_DELTA)
+			+ (time_t)(queued_ms / 1000);
 
 	/*
 	 * Fractional part is in units of 1.0/2³² seconds (~232 ps).  Convert
-	 * this to microseconds.
+	 * this to microseconds, then advance by the queueing delay so the
+	 * handler receives a time that is current as of *now*, not as of
+	 * packet arrival.
 	 */
-	ntp_client->tv.tv_usec = ntp_client->packet.txTm_f
-		/ NTP_TS_FRAC_PER_US;
+	uint32_t usec = ntp_frac_to_usec(txTm_f)
+			+ ((queued_ms % 1000) * 1000);
+	if (usec >= 1000000) {
+		usec -= 1000000;
+		ntp_client->tv.tv_sec++;
+	}
+	ntp_client->tv.tv_usec = usec;
+
+	/*
+	 * The same instant again at nanosecond resolution, straight from
+	 * the full 32-bit fraction — not by multiplying the truncated
+	 * microseconds back up.
+	 */
+	ntp_client->ts.tv_sec = (time_t)(txTm_s - NTP_TIMESTAMP_DELTA)
+			+ (time_t)(queued_ms / 1000);
+	uint32_t nsec = ntp_frac_to_nsec(txTm_f)
+			+ ((queued_ms % 1000) * 1000000);
+	if (nsec >= 1000000000) {
+		nsec -= 1000000000;
+		ntp_client->ts.tv_sec++;
+	}
+	ntp_client->ts.tv_nsec = nsec;
+
+	if ((ntp_client->state == NTP_CLIENT_RECV)
+			&& _ntp_client_burst_active(ntp_client)) {
+		/*
+		 * Mid-burst: fold this reply into the running minimum-delay
+		 * selection rather than reporting it.  The handler fires
+		 * once, with the best sample, when the burst concludes.
+		 */
+		if (!ntp_client->burst_recv
+				|| (ntp_client->delay
+					< ntp_client->best_delay)) {
+			ntp_client->best_offset = ntp_client->offset;
+			ntp_client->best_delay = ntp_client->delay;
+			ntp_client->best_tv = ntp_client->tv;
+			ntp_client->best_ts = ntp_client->ts;
+		}
+		ntp_client->burst_recv++;
+
+		if ((ntp_client->burst_sent >= ntp_client->burst_count)
+				&& (ntp_client->burst_recv
+					>= ntp_client->burst_sent)) {
+			/* Every reply is in; wrap up early */
+			_ntp_client_burst_finish(ntp_client);
+		} else {
+			/* Keep waiting on the rest of the burst */
+			ntp_client->state = NTP_CLIENT_SENT;
+		}
+		return;
+	}
+
+#if NTP_CLIENT_ENABLE_LISTEN
+	if ((ntp_client->state == NTP_CLIENT_RECV_BC)
+			&& (ntp_client->bc_window > 1)) {
+		/*
+		 * Mid-window: accumulate this broadcast's offset rather than
+		 * reporting it.  The handler fires once, with the median
+		 * sample, when the window fills — so a single delayed or
+		 * bogus broadcast is out-voted instead of yanking the clock.
+		 */
+		ntp_client->bc_offsets[ntp_client->bc_fill++] =
+				ntp_client->offset;
+		if (ntp_client->bc_fill < ntp_client->bc_window) {
+			ntp_client->state = NTP_CLIENT_LISTEN;
+			return;
+		}
+
+		_ntp_client_bc_filter(ntp_client);
+	}
+#endif
 
 	/* If there's a handler, call it now */
 	if (ntp_client->handler) {
@@ -310,9 +1085,11 @@ static void ntp_client_recv_done(struct ntp_client_t* const ntp_client) {
 	case NTP_CLIENT_RECV:
 		ntp_client->state = NTP_CLIENT_DONE;
 		break;
+#if NTP_CLIENT_ENABLE_LISTEN
 	case NTP_CLIENT_RECV_BC:
 		ntp_client->state = NTP_CLIENT_LISTEN;
 		break;
+#endif
 	default:
 		break;
 	}
@@ -322,6 +1099,36 @@ static void ntp_client_recv_done(struct ntp_client_t* const ntp_client) {
  * Handling of timeout
  */
 static void ntp_client_recv_timeout(struct ntp_client_t* const ntp_client) {
+	NTP_STATS_INC(ntp_client, timeouts);
+
+	if (!_ntp_client_burst_active(ntp_client)
+			&& ntp_client->sock_open
+			&& (ntp_client->retry_count
+				< ntp_client->retry_max)) {
+		/*
+		 * Retries remain: retransmit over the still-open socket
+		 * instead of tearing everything down and making the
+		 * application rebuild the poll from scratch.
+		 */
+		ntp_client->retry_count++;
+		_ntp_client_send(ntp_client);
+		return;
+	}
+
+	if (_ntp_client_burst_active(ntp_client)) {
+		if (ntp_client->burst_recv) {
+			/*
+			 * The window closed with at least one reply in
+			 * hand; that is a successful burst.
+			 */
+			_ntp_client_burst_finish(ntp_client);
+			return;
+		}
+
+		/* Nothing came back at all; fail the poll as usual. */
+		ntp_client->burst_count = 0;
+	}
+
 	/* Close off the socket, we're done now */
 	_ntp_client_shutdown(ntp_client);
 	if (ntp_client_is_done(ntp_client)) {
@@ -338,15 +1145,54 @@ static void ntp_client_recv_timeout(struct ntp_client_t* const ntp_client) {
 void ntp_client_process(struct ntp_client_t* const ntp_client) {
 	switch (ntp_client->state) {
 	case NTP_CLIENT_SENT:
-		if (ntp_client->timeout) {
-			ntp_client->timeout--;
-		} else {
+		if (_ntp_client_pop_event(ntp_client)) {
+			/* Reply arrived; the pop entered NTP_CLIENT_RECV */
+			ntp_client_recv_done(ntp_client);
+		} else if (_ntp_client_burst_active(ntp_client)
+				&& (ntp_client->burst_sent
+					< ntp_client->burst_count)
+				&& _ntp_ms_reached(otPlatAlarmMilliGetNow(),
+					ntp_client->burst_next_at)) {
+			/* Next burst transmission is due */
+			ntp_client->burst_sent++;
+			ntp_client->burst_next_at +=
+					ntp_client->burst_interval_ms;
+			_ntp_client_send(ntp_client);
+		} else if (_ntp_ms_reached(otPlatAlarmMilliGetNow(),
+					ntp_client->timeout_at)) {
 			/* Timeout reached */
 			ntp_client_recv_timeout(ntp_client);
 		}
 		break;
-	case NTP_CLIENT_RECV:
+	case NTP_CLIENT_SEND_PEND:
+		if (_ntp_client_pop_event(ntp_client)) {
+			/* A reply to an earlier transmission arrived */
+			ntp_client_recv_done(ntp_client);
+		} else if (_ntp_ms_reached(otPlatAlarmMilliGetNow(),
+					ntp_client->timeout_at)) {
+			/* Never got a buffer within the reply timeout */
+			ntp_client_recv_timeout(ntp_client);
+		} else if (_ntp_ms_reached(otPlatAlarmMilliGetNow(),
+					ntp_client->send_retry_at)) {
+			/* Re-attempt the deferred transmission */
+			_ntp_client_send(ntp_client);
+		}
+		break;
+#if NTP_CLIENT_ENABLE_LISTEN
+	case NTP_CLIENT_LISTEN:
+		/*
+		 * Drain every broadcast that arrived since the last call;
+		 * each event gets its own ntp_client_recv_done() pass and
+		 * handler invocation.
+		 */
+		while ((ntp_client->state == NTP_CLIENT_LISTEN)
+				&& _ntp_client_pop_event(ntp_client)) {
+			ntp_client_recv_done(ntp_client);
+		}
+		break;
 	case NTP_CLIENT_RECV_BC:
+#endif
+	case NTP_CLIENT_RECV:
 		ntp_client_recv_done(ntp_client);
 		break;
 	case NTP_CLIENT_ERR_TRUNC:
@@ -355,6 +1201,19 @@ void ntp_client_process(struct ntp_client_t* const ntp_client) {
 		 */
 		ntp_client->state = NTP_CLIENT_COMM_ERR;
 		break;
+	case NTP_CLIENT_ERR_KOD:
+		/*
+		 * The server kissed us off.  The backoff is already armed
+		 * (ntp_client_begin() refuses until it lapses); abandon
+		 * the poll.
+		 */
+		ntp_client->burst_count = 0;
+		_ntp_client_shutdown(ntp_client);
+		if (!ntp_client_is_done(ntp_client)) {
+			ntp_client->state = NTP_CLIENT_KOD;
+		}
+		break;
+#if NTP_CLIENT_ENABLE_LISTEN
 	case NTP_CLIENT_ERR_BC_TRUNC:
 		/*
 		 * If there was an error with truncated data, listen for next
@@ -362,8 +1221,128 @@ void ntp_client_process(struct ntp_client_t* const ntp_client) {
 		 */
 		ntp_client->state = NTP_CLIENT_LISTEN;
 		break;
+#endif
 	default:
 		/* Do nothing */
 		break;
 	}
 }
+
+/*!
+ * Set the retransmission policy for a client.
+ */
+otError ntp_client_set_retry(struct ntp_client_t* const ntp_client,
+		uint8_t max_retries) {
+	if (!ntp_client)
+		return OT_ERROR_PARSE;
+
+	ntp_client->retry_max = max_retries;
+	return OT_ERROR_NONE;
+}
+
+/*!
+ * Set the reply timeout for a client, in milliseconds.
+ */
+otError ntp_client_set_timeout(struct ntp_client_t* const ntp_client,
+		uint32_t timeout_ms) {
+	if (!ntp_client)
+		return OT_ERROR_PARSE;
+
+	ntp_client->timeout_ms = timeout_ms;
+	return OT_ERROR_NONE;
+}
+
+#if NTP_CLIENT_ENABLE_LISTEN
+/*!
+ * Set the number of broadcast samples batched per handler invocation.
+ */
+otError ntp_client_set_bc_window(struct ntp_client_t* const ntp_client,
+		uint8_t samples) {
+	if (!ntp_client)
+		return OT_ERROR_PARSE;
+	if (samples > NTP_CLIENT_BC_WINDOW_MAX)
+		return OT_ERROR_INVALID_ARGS;
+
+	ntp_client->bc_window = samples;
+	return OT_ERROR_NONE;
+}
+#endif /* NTP_CLIENT_ENABLE_LISTEN */
+
+/*!
+ * Return the number of milliseconds until this client's pending request
+ * times out, or zero if nothing is pending.
+ */
+uint32_t ntp_client_timeout_in(const struct ntp_client_t* const ntp_client) {
+	uint32_t deadline;
+
+	switch (ntp_client->state) {
+	case NTP_CLIENT_SENT:
+		/* The next burst transmission may be due before the timeout */
+		deadline = ntp_client->timeout_at;
+		if (ntp_client->burst_count
+				&& (ntp_client->burst_sent
+					< ntp_client->burst_count)
+				&& ((int32_t)(ntp_client->burst_next_at
+					- deadline) < 0))
+			deadline = ntp_client->burst_next_at;
+		break;
+	case NTP_CLIENT_SEND_PEND:
+		/* The deferred re-attempt may be due before the timeout */
+		deadline = ntp_client->send_retry_at;
+		if ((int32_t)(ntp_client->timeout_at - deadline) < 0)
+			deadline = ntp_client->timeout_at;
+		break;
+	default:
+		return 0;
+	}
+
+	uint32_t now = otPlatAlarmMilliGetNow();
+	if (_ntp_ms_reached(now, deadline))
+		return 0;
+
+	return deadline - now;
+}
+
+/*!
+ * Return the number of milliseconds until this client's server may be
+ * polled again, or zero if a poll is permitted now.
+ */
+uint32_t ntp_client_poll_in(const struct ntp_client_t* const ntp_client) {
+	if (!ntp_client->poll_not_before)
+		return 0;
+
+	uint32_t now = otPlatAlarmMilliGetNow();
+	if (_ntp_ms_reached(now, ntp_client->poll_not_before))
+		return 0;
+
+	return ntp_client->poll_not_before - now;
+}
+
+/*!
+ * Return the number of milliseconds until the client's time error may
+ * exceed `target_usec`.
+ */
+uint32_t ntp_client_next_poll_in(const struct ntp_client_t* const ntp_client,
+		uint32_t target_usec) {
+	if (!ntp_client || !ntp_client->sync_err_usec)
+		return 0;
+	if (ntp_client->sync_err_usec >= target_usec)
+		return 0;
+
+	/*
+	 * The budget left over the sync's own error bound is spent by
+	 * local drift at NTP_CLIENT_DRIFT_PPM — one ppm being one
+	 * microsecond of error per second — of which some has been
+	 * spent already since the sample arrived.
+	 */
+	uint64_t budget_ms = (((uint64_t)target_usec
+				- ntp_client->sync_err_usec) * 1000ull)
+			/ NTP_CLIENT_DRIFT_PPM;
+	uint32_t elapsed_ms = otPlatAlarmMilliGetNow()
+			- ntp_client->sample_rx_ms;
+	if (budget_ms <= elapsed_ms)
+		return 0;
+
+	budget_ms -= elapsed_ms;
+	return (budget_ms > UINT32_MAX) ? UINT32_MAX : (uint32_t)budget_ms;
+}
@@ -7,9 +7,12 @@
  * (C) 2014 David Lettier <http://www.lettier.com>.
  * Code used with permission.
  */
+#ifndef _NTP_H
+#define _NTP_H
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <time.h>
 #include <sys/time.h>
 #include <openthread/instance.h>
 #include <openthread/ip6.h>
@@ -20,56 +23,188 @@
  */
 #define NTP_CLIENT_DEFAULT_PORT	(123)
 
+/*!
+ * Convert the fractional part of an NTP time-stamp (units of 1/2³²
+ * seconds, ~233 ps) to microseconds.  Implemented as a 64-bit multiply
+ * and shift rather than a divide by the approximate 4295 fractional
+ * units per microsecond: exact (to the floor) and fast on cores without
+ * hardware division.
+ *
+ * @param[in]	frac	NTP time-stamp fraction, host byte order
+ */
+static inline uint32_t ntp_frac_to_usec(uint32_t frac) {
+	return (uint32_t)(((uint64_t)frac * 1000000ull) >> 32);
+}
+
+/*!
+ * Convert microseconds (0…999999) to an NTP time-stamp fraction.
+ *
+ * @param[in]	usec	Microseconds within the second
+ */
+static inline uint32_t ntp_usec_to_frac(uint32_t usec) {
+	return (uint32_t)((((uint64_t)usec) << 32) / 1000000ull);
+}
+
+/*!
+ * Convert the fractional part of an NTP time-stamp to nanoseconds, using
+ * the full 32-bit fraction — same multiply-and-shift scheme as
+ * ntp_frac_to_usec(), no division, nothing truncated to microseconds on
+ * the way.
+ *
+ * @param[in]	frac	NTP time-stamp fraction, host byte order
+ */
+static inline uint32_t ntp_frac_to_nsec(uint32_t frac) {
+	return (uint32_t)(((uint64_t)frac * 1000000000ull) >> 32);
+}
+
 /* Forward declaration */
 struct ntp_client_t;
 
-/*! Structure that defines the 48 byte NTP packet protocol. */
-struct ntp_packet_t {
-	/*! Only two bits. Leap indicator. */
-	unsigned li	: 2;
-	/*! Only three bits. Version number of the protocol. */
-	unsigned vn	: 3;
-	/*! Only three bits. Mode. Client will pick mode 3 for client. */
-	unsigned mode	: 3;
-
-	/*! Eight bits. Stratum level of the local clock. */
-	uint8_t stratum;
-	/*! Eight bits. Maximum interval between successive messages. */
-	uint8_t poll;
-	/*! Eight bits. Precision of the local clock. */
-	uint8_t precision;
-
-	/*! 32 bits. Total round trip delay time. */
-	uint32_t rootDelay;
-	/*! 32 bits. Max error aloud from primary clock source. */
-	uint32_t rootDispersion;
-	/*! 32 bits. Reference clock identifier. */
-	uint32_t refId;
-
-	/*! 32 bits. Reference time-stamp seconds. */
-	uint32_t refTm_s;
-	/*! 32 bits. Reference time-stamp fraction of a second. */
-	uint32_t refTm_f;
-
-	/*! 32 bits. Originate time-stamp seconds. */
+/*
+ * The 48-byte NTP packet is described by explicit byte offsets in
+ * ntp_wire.h rather than a C struct: the bitfield layout of the old
+ * struct ntp_packet_t was compiler- and endian-dependent.
+ */
+
+/*!
+ * The slice of the NTP packet the receive path actually uses: the
+ * originate, receive and transmit time-stamps, which sit contiguously at
+ * byte offsets 24-47 of the wire format.  These are read as one block
+ * straight out of the otMessage, so the other 24 bytes are never copied
+ * and the client's own request packet is left untouched.  Fields are in
+ * network byte order as received.
+ */
+struct ntp_sample_t {
+	/*! Originate time-stamp (echo of our request's transmit time) */
 	uint32_t origTm_s;
-	/*! 32 bits. Originate time-stamp fraction of a second. */
+	/*! Originate time-stamp fraction */
 	uint32_t origTm_f;
-
-	/*! 32 bits. Received time-stamp seconds. */
+	/*! Server receive time-stamp seconds */
 	uint32_t rxTm_s;
-	/*! 32 bits. Received time-stamp fraction of a second. */
+	/*! Server receive time-stamp fraction */
 	uint32_t rxTm_f;
+	/*! Server transmit time-stamp seconds */
+	uint32_t txTm_s;
+	/*! Server transmit time-stamp fraction */
+	uint32_t txTm_f;
+};
+
+/*!
+ * Compile-time switch for the broadcast listen path: ntp_client_listen(),
+ * the multicast-subscribe logic and the broadcast branches of the state
+ * machine (plus the listener registry module, which depends on them).
+ * Build with -DNTP_CLIENT_ENABLE_LISTEN=0 on poll-only devices to strip
+ * the flash and per-client RAM they cost.
+ */
+#ifndef NTP_CLIENT_ENABLE_LISTEN
+#define NTP_CLIENT_ENABLE_LISTEN	(1)
+#endif
+
+/*! Upper bound on broadcast samples per listen reporting window */
+#define NTP_CLIENT_BC_WINDOW_MAX	(8)
+
+/*!
+ * Transmit time-stamps remembered per poll for origin matching.  Must be
+ * a power of two, and at least NTP_CLIENT_BURST_MAX so every request of
+ * a burst stays matchable.
+ */
+#define NTP_CLIENT_TX_STAMPS		(8)
+
+/*!
+ * Number of slots in the received-event ring.  Must be a power of two.
+ * One slot is sacrificed to distinguish full from empty, so the ring
+ * absorbs a burst of NTP_CLIENT_EVENT_RING - 1 packets between calls to
+ * ntp_client_process().
+ */
+#ifndef NTP_CLIENT_EVENT_RING
+#define NTP_CLIENT_EVENT_RING	(4)
+#endif
+
+/*!
+ * A received-packet event, queued by the receive callback (which runs in
+ * OpenThread's context) and drained by ntp_client_process() (which runs
+ * in the main loop).
+ */
+struct ntp_client_event_t {
+	/*! Time-stamps read from the packet */
+	struct ntp_sample_t	sample;
 
 	/*!
-	 * 32 bits and the most important field the client cares
-	 * about. Transmit time-stamp seconds.
+	 * Local millisecond clock (otPlatAlarmMilliGetNow()) captured the
+	 * moment the otMessage was delivered, so later processing can
+	 * compensate for however long the event sat in the ring.
 	 */
-	uint32_t txTm_s;
-	/*! 32 bits. Transmit time-stamp fraction of a second. */
-	uint32_t txTm_f;
+	uint32_t		rx_ms;
+
+	/*! The packet's root delay field (NTP short format, network order) */
+	uint32_t		root_delay;
+
+	/*! The packet's root dispersion field (as root_delay) */
+	uint32_t		root_disp;
+
+	/*! The packet's poll field (log₂ seconds) */
+	uint8_t			srv_poll;
+
+	/*! The packet's stratum field */
+	uint8_t			srv_stratum;
+
+#if NTP_CLIENT_ENABLE_LISTEN
+	/*! True if this arrived as a broadcast (listen mode) */
+	uint8_t			bc;
+#endif
 };
 
+/*!
+ * Compile-time switch for the per-client statistics counters.  Build
+ * with -DNTP_CLIENT_ENABLE_STATS=0 to compile them out entirely.
+ */
+#ifndef NTP_CLIENT_ENABLE_STATS
+#define NTP_CLIENT_ENABLE_STATS	(1)
+#endif
+
+#if NTP_CLIENT_ENABLE_STATS
+/*!
+ * Per-client statistics, updated on the existing state transitions.
+ * Counters accumulate across successive polls of the same client, so a
+ * slow server or lossy route shows up without a debugger attached.  The
+ * round-trip EWMA itself lives in ntp_client_t::rtt_ewma_ms.
+ */
+struct ntp_client_stats_t {
+	/*! Requests transmitted, including retries and burst members */
+	uint32_t		tx;
+
+	/*! Valid unicast replies processed */
+	uint32_t		rx;
+
+	/*! Broadcast updates processed */
+	uint32_t		rx_bc;
+
+	/*! Truncated unicast replies (NTP_CLIENT_ERR_TRUNC) */
+	uint32_t		trunc;
+
+	/*! Truncated broadcasts (NTP_CLIENT_ERR_BC_TRUNC) */
+	uint32_t		bc_trunc;
+
+	/*! Reply timeouts, including those answered by a retransmission */
+	uint32_t		timeouts;
+
+	/*! Transmissions deferred waiting for a message buffer */
+	uint32_t		no_bufs;
+
+	/*! Unicast replies dropped for an unmatched originate stamp */
+	uint32_t		bad_orig;
+
+	/*! Smallest round trip observed, milliseconds (0 = none yet) */
+	uint32_t		rtt_min_ms;
+
+	/*! Largest round trip observed, milliseconds */
+	uint32_t		rtt_max_ms;
+
+	/*! Offset computed by the most recent exchange, microseconds */
+	int64_t			last_offset;
+};
+#endif /* NTP_CLIENT_ENABLE_STATS */
+
 /*!
  * NTP Client event handler callback.  This is called each time the NTP client
  * receives an error or time update.  Context may be accessed via
@@ -97,20 +232,244 @@ struct ntp_client_t {
 	/*! UDP socket */
 	otUdpSocket			socket;
 
-	/*! NTP packet payload */
-	struct ntp_packet_t		packet;
+	/*! Time-stamps of the last received reply or broadcast */
+	struct ntp_sample_t		sample;
+
+	/*! Local millisecond clock at the moment `sample` was received */
+	uint32_t			sample_rx_ms;
+
+	/*! Poll field (log₂ seconds) of the last received packet */
+	uint8_t				srv_poll;
+
+	/*! Stratum field of the last received packet */
+	uint8_t				srv_stratum;
+
+	/*! Root delay of the last received packet (network order) */
+	uint32_t			root_delay;
+
+	/*! Root dispersion of the last received packet (network order) */
+	uint32_t			root_disp;
+
+	/*!
+	 * Error bound of the last completed sync at the moment it was
+	 * taken, in microseconds: the server's root dispersion plus half
+	 * its root delay.  Grows with local drift from there; zero until
+	 * the first sync.  Input to ntp_client_next_poll_in().
+	 */
+	uint32_t			sync_err_usec;
+
+	/*!
+	 * Single-producer/single-consumer ring of received events.  The
+	 * receive callback enqueues at ev_head; ntp_client_process()
+	 * dequeues at ev_tail.  Neither index is touched by the other
+	 * side, so no locking is needed, and a burst of packets is
+	 * absorbed instead of each overwriting the last.
+	 */
+	struct ntp_client_event_t	events[NTP_CLIENT_EVENT_RING];
+
+	/*! Producer index into `events` */
+	volatile uint8_t		ev_head;
+
+	/*! Consumer index into `events` */
+	volatile uint8_t		ev_tail;
 
 	/*! Received timestamp information */
 	struct timeval			tv;
 
+	/*!
+	 * The same instant as `tv` at nanosecond resolution, computed from
+	 * the full 32-bit NTP fraction.  Consumers that want nanoseconds
+	 * (PTP bridging and the like) read this directly instead of
+	 * multiplying the already-truncated microseconds back up.
+	 */
+	struct timespec			ts;
+
+	/*! Local time-stamp taken when the request was transmitted */
+	struct timeval			tv_tx;
+
+	/*!
+	 * NTP-format transmit time-stamps of this poll's requests, a ring
+	 * of the most recent NTP_CLIENT_TX_STAMPS transmissions.  A
+	 * unicast reply is accepted only if its echoed originate
+	 * time-stamp matches one of these, and T1 is derived from the
+	 * echo itself — so a reply landing after a retransmission or the
+	 * next burst request is scored against the transmission it
+	 * actually answers, not the latest one.
+	 */
+	uint32_t			tx_stamps_s[NTP_CLIENT_TX_STAMPS];
+
+	/*! Fraction words of `tx_stamps_s` */
+	uint32_t			tx_stamps_f[NTP_CLIENT_TX_STAMPS];
+
+	/*! Next slot of the transmit time-stamp ring to fill */
+	uint8_t				tx_stamp_head;
+
+	/*!
+	 * Estimated offset of the local clock relative to the server, in
+	 * microseconds.  Valid from the moment the event handler is called.
+	 * For broadcast updates this degrades to the raw one-way difference
+	 * (server transmit time minus local receive time) since no round
+	 * trip is available.
+	 */
+	int64_t				offset;
+
+	/*!
+	 * Measured round-trip delay of the exchange, in microseconds.
+	 * Zero for broadcast updates.
+	 */
+	int64_t				delay;
+
 	/*! Result state */
 	volatile otError		error;
 
-	/*! Timeout remaining */
-	volatile uint16_t		timeout;
+	/*!
+	 * Absolute deadline for the reply, in milliseconds on the platform
+	 * alarm clock (otPlatAlarmMilliGetNow() time base, modulo 2³²).
+	 */
+	volatile uint32_t		timeout_at;
 
 	/*! Client state */
 	volatile uint8_t		state;
+
+	/*! True whilst `socket` is open */
+	bool				sock_open;
+
+	/*!
+	 * Keep the socket open across successive polls.  Set by
+	 * ntp_client_begin_persistent(); cleared by ntp_client_shutdown().
+	 */
+	bool				persistent;
+
+#if NTP_CLIENT_ENABLE_LISTEN
+	/*!
+	 * True whilst this client holds a reference on the multicast group
+	 * in `peer_addr`; ntp_client_shutdown() releases it.
+	 */
+	bool				mcast_subscribed;
+#endif
+
+	/*! Address of the server being polled */
+	otIp6Address			peer_addr;
+
+	/*! Port of the server being polled */
+	uint16_t			peer_port;
+
+	/*! Time-to-live for transmitted requests */
+	uint8_t				ttl;
+
+	/*! Requests in the current burst; zero for a single-shot poll */
+	uint8_t				burst_count;
+
+	/*! Requests transmitted so far in this burst */
+	uint8_t				burst_sent;
+
+	/*! Replies received so far in this burst */
+	uint8_t				burst_recv;
+
+	/*! Spacing between burst transmissions, in milliseconds */
+	uint16_t			burst_interval_ms;
+
+	/*! Deadline for the next burst transmission */
+	uint32_t			burst_next_at;
+
+	/*! Offset of the lowest-delay sample seen this burst */
+	int64_t				best_offset;
+
+	/*! Delay of the lowest-delay sample seen this burst */
+	int64_t				best_delay;
+
+	/*! Received time of the lowest-delay sample seen this burst */
+	struct timeval			best_tv;
+
+	/*! Nanosecond-resolution twin of `best_tv` */
+	struct timespec			best_ts;
+
+#if NTP_CLIENT_ENABLE_LISTEN
+	/*!
+	 * Broadcast samples accumulated per handler invocation whilst
+	 * listening; zero or one reports every broadcast individually.
+	 * Set by ntp_client_set_bc_window().
+	 */
+	uint8_t				bc_window;
+
+	/*! Broadcast samples accumulated in the current window */
+	uint8_t				bc_fill;
+
+	/*! Offsets of the samples accumulated this window */
+	int64_t				bc_offsets[NTP_CLIENT_BC_WINDOW_MAX];
+#endif
+
+	/*!
+	 * Exponentially-weighted moving average of the round-trip time,
+	 * in milliseconds; zero until the first successful exchange.  The
+	 * reply timeout is derived from this (a small multiple, floored
+	 * and ceilinged), so a lost packet on a 50 ms link is detected in
+	 * well under a second instead of stalling for the full static
+	 * timeout.  Preserved across successive polls on this client.
+	 */
+	uint32_t			rtt_ewma_ms;
+
+	/*!
+	 * Configured reply timeout, in milliseconds; zero (the default)
+	 * selects the adaptive timeout derived from rtt_ewma_ms.  Preserved
+	 * across successive polls; set via ntp_client_set_timeout().
+	 */
+	uint32_t			timeout_ms;
+
+	/*!
+	 * Maximum number of retransmissions after the initial request.
+	 * Zero (the default) keeps the original behaviour: one shot, then
+	 * NTP_CLIENT_TIMEOUT.  Preserved across successive polls; set via
+	 * ntp_client_set_retry().
+	 */
+	uint8_t				retry_max;
+
+	/*! Retransmissions performed so far for this poll */
+	uint8_t				retry_count;
+
+	/*!
+	 * Millisecond deadline for the next transmission attempt while in
+	 * NTP_CLIENT_SEND_PEND: under buffer pressure (otUdpNewMessage()
+	 * or otUdpSend() reporting OT_ERROR_NO_BUFS) the poll is deferred
+	 * and re-attempted from ntp_client_process() with backoff, rather
+	 * than failed outright.  The overall reply timeout still bounds the
+	 * poll.
+	 */
+	uint32_t			send_retry_at;
+
+	/*! Current allocation-retry backoff, in milliseconds */
+	uint16_t			send_backoff_ms;
+
+	/*!
+	 * Raw refId bytes of the last Kiss-o'-Death reply (an ASCII code
+	 * such as "RATE" or "DENY"), network byte order.  Zero if no KoD
+	 * has been seen.
+	 */
+	uint32_t			kiss_code;
+
+	/*!
+	 * Minimum poll interval the server asked for via its poll field,
+	 * in seconds.  Preserved across successive polls.
+	 */
+	uint16_t			min_poll_s;
+
+	/*!
+	 * Current Kiss-o'-Death backoff, in seconds; doubles on each KoD
+	 * and clears on the next successful exchange.
+	 */
+	uint16_t			kod_backoff_s;
+
+	/*!
+	 * Millisecond deadline before which ntp_client_begin() refuses
+	 * (OT_ERROR_BUSY) to poll this server again, enforcing both the
+	 * server's poll field and any KoD backoff.
+	 */
+	uint32_t			poll_not_before;
+
+#if NTP_CLIENT_ENABLE_STATS
+	/*! Statistics counters; preserved across successive polls */
+	struct ntp_client_stats_t	stats;
+#endif
 };
 
 /*! Client is being initialised */
@@ -119,18 +478,24 @@ struct ntp_client_t {
 #define NTP_CLIENT_LISTEN	(0x10)
 /*! Client has sent the request and is waiting */
 #define NTP_CLIENT_SENT		(0x20)
+/*! Client is waiting for a message buffer to transmit its request */
+#define NTP_CLIENT_SEND_PEND	(0x28)
 /*! Client has received a reply from the NTP server. */
 #define NTP_CLIENT_RECV		(0xa0)
 /*! Client has received a broadcast the NTP server. */
 #define NTP_CLIENT_RECV_BC	(0xb0)
 /*! Client received truncated data */
 #define NTP_CLIENT_ERR_TRUNC	(0xe0)
+/*! Client received a Kiss-o'-Death reply (pending processing) */
+#define NTP_CLIENT_ERR_KOD	(0xe5)
 /*! Client received truncated broadcast data */
 #define NTP_CLIENT_ERR_BC_TRUNC	(0xeb)
 /*! Client has processed the reply and is now done. */
 #define NTP_CLIENT_DONE		(0xf0)
 /*! Client had an internal error. */
 #define NTP_CLIENT_INT_ERR	(0xf1)
+/*! Server sent a Kiss-o'-Death; back off (see kiss_code). */
+#define NTP_CLIENT_KOD		(0xfb)
 /*! Communications error with server */
 #define NTP_CLIENT_COMM_ERR	(0xfc)
 /*! Client did not receive a reply and has timed out. */
@@ -161,6 +526,64 @@ otError ntp_client_begin(otInstance* instance,
 		ntp_client_event_handler_t handler,
 		void* handler_context);
 
+/*!
+ * Initiate a poll of an NTP server, keeping the UDP socket open once the
+ * poll completes.  Subsequent calls on the same client re-use the open
+ * socket, avoiding the otUdpOpen()/otUdpClose() cost of each exchange.
+ * The socket remains open until ntp_client_shutdown() is called.
+ *
+ * @param[inout]	instance	OpenThread instance to use for this
+ * 					client's context.
+ * @param[inout]	ntp_client	NTP client instance
+ * @param[in]		addr		IPv6 address of NTP server
+ * @param[in]		port		Port number of NTP server
+ * @param[in]		ttl		Message time-to-live
+ * @param[in]		handler		NTP event handler
+ * @param[in]		handler_context	NTP event handler context
+ */
+otError ntp_client_begin_persistent(otInstance* instance,
+		struct ntp_client_t* const ntp_client,
+		const otIp6Address* addr, uint16_t port,
+		uint8_t ttl,
+		ntp_client_event_handler_t handler,
+		void* handler_context);
+
+/*! Upper bound on requests per burst */
+#define NTP_CLIENT_BURST_MAX		(8)
+
+/*! Default spacing between burst transmissions, in milliseconds */
+#define NTP_CLIENT_BURST_INTERVAL_MS	(50)
+
+/*!
+ * Poll an NTP server with a burst of requests and report the single
+ * sample with the lowest round-trip delay.  `count` requests are sent
+ * `interval_ms` apart over one socket; once every reply is in (or the
+ * window times out with at least one reply in hand), the event handler
+ * is invoked exactly once with the best sample in `offset`/`delay`/`tv`.
+ * Minimum-delay filtering strips queueing jitter without raising the
+ * overall poll rate.
+ *
+ * @param[inout]	instance	OpenThread instance to use for this
+ * 					client's context.
+ * @param[inout]	ntp_client	NTP client instance
+ * @param[in]		addr		IPv6 address of NTP server
+ * @param[in]		port		Port number of NTP server
+ * @param[in]		ttl		Message time-to-live
+ * @param[in]		count		Requests per burst
+ * 					(1…NTP_CLIENT_BURST_MAX)
+ * @param[in]		interval_ms	Spacing between requests; zero
+ * 					selects the default
+ * @param[in]		handler		NTP event handler
+ * @param[in]		handler_context	NTP event handler context
+ */
+otError ntp_client_begin_burst(otInstance* instance,
+		struct ntp_client_t* const ntp_client,
+		const otIp6Address* addr, uint16_t port,
+		uint8_t ttl, uint8_t count, uint16_t interval_ms,
+		ntp_client_event_handler_t handler,
+		void* handler_context);
+
+#if NTP_CLIENT_ENABLE_LISTEN
 /*!
  * Listen for broadcast NTP time updates from an NTP server.
  *
@@ -178,14 +601,119 @@ otError ntp_client_listen(otInstance* instance,
 		ntp_client_event_handler_t handler,
 		void* handler_context);
 
+/*!
+ * Batch broadcast samples whilst listening: accumulate `samples`
+ * broadcasts, then invoke the handler once with the median-offset
+ * result.  One handler invocation (and one clock adjustment) per window
+ * instead of per packet, and a single delayed or bogus broadcast in the
+ * window is out-voted instead of yanking the reported time.  Zero or
+ * one restores per-broadcast reporting.  Set it after
+ * ntp_client_listen(), which resets the client's state.
+ *
+ * @param[inout]	ntp_client	NTP client instance
+ * @param[in]		samples		Broadcasts per handler invocation
+ * 					(0…NTP_CLIENT_BC_WINDOW_MAX)
+ */
+otError ntp_client_set_bc_window(struct ntp_client_t* const ntp_client,
+		uint8_t samples);
+#endif /* NTP_CLIENT_ENABLE_LISTEN */
+
 /*!
  * Shutdown a listening client.
  * @param[inout]	ntp_client	NTP client instance
  */
 otError ntp_client_shutdown(struct ntp_client_t* const ntp_client);
 
+/*!
+ * Set the retransmission policy for a client.  When a reply timeout
+ * expires and retries remain, the request is retransmitted over the
+ * still-open socket — no socket teardown, re-open or re-registration —
+ * with the reply timeout doubling on each attempt.  Only after the last
+ * attempt expires does the client land in NTP_CLIENT_TIMEOUT.  May be
+ * called any time after the client is first started; the setting is
+ * preserved across successive polls.
+ *
+ * @param[inout]	ntp_client	NTP client instance
+ * @param[in]		max_retries	Retransmissions allowed after the
+ * 					initial request (0 disables)
+ */
+otError ntp_client_set_retry(struct ntp_client_t* const ntp_client,
+		uint8_t max_retries);
+
+/*!
+ * Set the reply timeout for a client, in milliseconds.  Zero (the
+ * default) selects the adaptive timeout: a small multiple of the measured
+ * round-trip EWMA, bounded by the static maximum.  The timeout counts
+ * down against the platform millisecond clock, so it is independent of
+ * how often the main loop calls ntp_client_process() — a 10 Hz and a 1 Hz
+ * loop see the same effective timeout.  May be called any time after the
+ * client is first started; the setting is preserved across successive
+ * polls.
+ *
+ * @param[inout]	ntp_client	NTP client instance
+ * @param[in]		timeout_ms	Reply timeout in milliseconds
+ * 					(0 restores the adaptive default)
+ */
+otError ntp_client_set_timeout(struct ntp_client_t* const ntp_client,
+		uint32_t timeout_ms);
+
 /*!
  * Process the state of the NTP client.  This should be called in a loop.
+ *
+ * Timeouts are checked against the platform millisecond clock rather
+ * than counted in calls, so the loop need not run at any particular
+ * cadence: it is sufficient to call this after a receive event and
+ * whenever the interval returned by ntp_client_timeout_in() elapses,
+ * sleeping in between.
+ *
  * @param[inout]	ntp_client	NTP client instance
  */
 void ntp_client_process(struct ntp_client_t* const ntp_client);
+
+/*!
+ * Return the number of milliseconds until this client's pending request
+ * times out, or zero if no request is pending (or the deadline has
+ * already passed).  Intended for driving a wake-up timer so the main
+ * loop can sleep instead of polling ntp_client_process().
+ *
+ * @param[in]		ntp_client	NTP client instance
+ */
+uint32_t ntp_client_timeout_in(const struct ntp_client_t* const ntp_client);
+
+/*!
+ * Return the number of milliseconds until this client's server may be
+ * polled again, or zero if a poll is permitted now.  The interval
+ * honours the server's advertised poll field and any Kiss-o'-Death
+ * backoff in force; ntp_client_begin() refuses with OT_ERROR_BUSY
+ * inside it.
+ *
+ * @param[in]		ntp_client	NTP client instance
+ */
+uint32_t ntp_client_poll_in(const struct ntp_client_t* const ntp_client);
+
+/*!
+ * Assumed local oscillator drift, in parts per million, for error-budget
+ * scheduling.  The traditional NTP frequency tolerance.
+ */
+#ifndef NTP_CLIENT_DRIFT_PPM
+#define NTP_CLIENT_DRIFT_PPM	(15)
+#endif
+
+/*!
+ * Return the number of milliseconds until the client's time error may
+ * exceed `target_usec`, i.e. the latest moment a re-poll is needed to
+ * stay within the caller's accuracy target.  The error bound starts at
+ * the last sync's root dispersion plus half its root delay
+ * (sync_err_usec) and grows at NTP_CLIENT_DRIFT_PPM.  Returns zero if
+ * the target is already exceeded — or if the client has never completed
+ * a sync — meaning: poll now.  Polling on this schedule instead of a
+ * fixed timer is the cheapest bandwidth/power win available; a good
+ * sample against a nearby server can push the next poll out by hours.
+ *
+ * @param[in]		ntp_client	NTP client instance
+ * @param[in]		target_usec	Accuracy target, microseconds
+ */
+uint32_t ntp_client_next_poll_in(const struct ntp_client_t* const ntp_client,
+		uint32_t target_usec);
+
+#endif
@@ -0,0 +1,106 @@
+/* vim: set noet tw=78 si: */
+/*!
+ * OpenThread NTP Client: disciplined local clock
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+
+#include "ntp_clock.h"
+#include <string.h>
+#include <openthread/platform/alarm-milli.h>
+
+/*! Clamp on the frequency correction: ±500 ppm, as ntpd uses */
+#define NTP_CLOCK_FREQ_MAX_PPB	(500000)
+
+/*! Integral gain divisor of the PI loop */
+#define NTP_CLOCK_INTEG_DIV	(4)
+
+/* Microseconds elapsed on the corrected local clock since base_ms */
+static int64_t _ntp_clock_elapsed_usec(
+		const struct ntp_clock_t* const clock, uint32_t now_ms) {
+	int64_t raw_usec = (int64_t)(uint32_t)(now_ms - clock->base_ms)
+			* 1000ll;
+	return raw_usec + ((raw_usec * clock->freq_ppb) / 1000000000ll);
+}
+
+/*!
+ * Initialise (or reset) a disciplined clock.
+ */
+void ntp_clock_init(struct ntp_clock_t* const clock) {
+	if (!clock)
+		return;
+	memset(clock, 0, sizeof(struct ntp_clock_t));
+}
+
+/*!
+ * Apply one time sample to the discipline loop.
+ */
+otError ntp_clock_update(struct ntp_clock_t* const clock,
+		const struct timeval* tv) {
+	if (!clock || !tv)
+		return OT_ERROR_PARSE;
+
+	uint32_t now_ms = otPlatAlarmMilliGetNow();
+	int64_t measured = ((int64_t)tv->tv_sec * 1000000ll)
+			+ (int64_t)tv->tv_usec;
+
+	if (!clock->valid || clock->stale) {
+		/* First believable sample: step straight to it */
+		clock->base_usec = measured;
+		clock->base_ms = now_ms;
+		clock->valid = true;
+		clock->stale = false;
+		return OT_ERROR_NONE;
+	}
+
+	int64_t elapsed = _ntp_clock_elapsed_usec(clock, now_ms);
+	int64_t predicted = clock->base_usec + elapsed;
+	int64_t err_usec = measured - predicted;
+
+	/*
+	 * PI discipline: the phase error is taken up in full
+	 * (proportional term), and a fraction of the implied frequency
+	 * error — phase error over the interval it accumulated in — is
+	 * folded into the running correction (integral term).
+	 */
+	if (elapsed > 0) {
+		int64_t drift_ppb = (err_usec * 1000000000ll) / elapsed;
+		int64_t freq = (int64_t)clock->freq_ppb
+				+ (drift_ppb / NTP_CLOCK_INTEG_DIV);
+		if (freq > NTP_CLOCK_FREQ_MAX_PPB)
+			freq = NTP_CLOCK_FREQ_MAX_PPB;
+		if (freq < -NTP_CLOCK_FREQ_MAX_PPB)
+			freq = -NTP_CLOCK_FREQ_MAX_PPB;
+		clock->freq_ppb = (int32_t)freq;
+	}
+
+	clock->base_usec = measured;
+	clock->base_ms = now_ms;
+	return OT_ERROR_NONE;
+}
+
+/*!
+ * Read the disciplined clock.
+ */
+otError ntp_clock_now(struct ntp_clock_t* const clock,
+		struct timeval* tv) {
+	if (!clock || !tv)
+		return OT_ERROR_PARSE;
+	if (!clock->valid)
+		return OT_ERROR_INVALID_STATE;
+
+	uint32_t now_ms = otPlatAlarmMilliGetNow();
+	int64_t now_usec = clock->base_usec
+			+ _ntp_clock_elapsed_usec(clock, now_ms);
+
+	/*
+	 * Roll the base forward so the unsigned millisecond delta never
+	 * has to span more than one call interval; this is what makes the
+	 * 2³² ms wrap of the platform clock safe.
+	 */
+	clock->base_usec = now_usec;
+	clock->base_ms = now_ms;
+
+	tv->tv_sec = (time_t)(now_usec / 1000000ll);
+	tv->tv_usec = (suseconds_t)(now_usec % 1000000ll);
+	return OT_ERROR_NONE;
+}
@@ -0,0 +1,74 @@
+/* vim: set tw=78 noet si sw=8 ts=8: */
+/*!
+ * OpenThread NTP Client: disciplined local clock
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+#ifndef _NTP_CLOCK_H
+#define _NTP_CLOCK_H
+
+#include "ntp.h"
+
+/*!
+ * A software-disciplined clock.  Feed it the time reported by each
+ * completed poll (ntp_client->tv) and it estimates the local
+ * oscillator's frequency error with a simple PI loop, so
+ * ntp_clock_now() can extrapolate accurately between polls.  With drift
+ * compensated, the poll interval can be stretched by an order of
+ * magnitude for the same error bound.
+ */
+struct ntp_clock_t {
+	/*! Disciplined time, microseconds since the UNIX epoch, at base_ms */
+	int64_t			base_usec;
+
+	/*! Platform millisecond clock reading paired with base_usec */
+	uint32_t		base_ms;
+
+	/*!
+	 * Frequency correction applied to the platform clock, in parts
+	 * per billion (positive = local oscillator runs slow).
+	 */
+	int32_t			freq_ppb;
+
+	/*! True once at least one sample has been applied */
+	bool			valid;
+
+	/*!
+	 * True when the current time came from persisted state rather
+	 * than a live exchange; cleared by the next ntp_clock_update().
+	 */
+	bool			stale;
+};
+
+/*!
+ * Initialise (or reset) a disciplined clock.  The clock reports no time
+ * until the first update.
+ *
+ * @param[inout]	clock		Clock instance
+ */
+void ntp_clock_init(struct ntp_clock_t* const clock);
+
+/*!
+ * Apply one time sample, as reported in ntp_client->tv when a poll
+ * completes.  The first sample sets the clock; subsequent samples slew
+ * the phase and refine the frequency estimate.
+ *
+ * @param[inout]	clock		Clock instance
+ * @param[in]		tv		Sampled time
+ */
+otError ntp_clock_update(struct ntp_clock_t* const clock,
+		const struct timeval* tv);
+
+/*!
+ * Read the disciplined clock: the last sample extrapolated forward on
+ * the platform millisecond clock with the frequency correction applied.
+ * Must be called at least once per platform-clock wrap (~49 days), which
+ * any real poll schedule satisfies.  Fails with OT_ERROR_INVALID_STATE
+ * before the first update (or restore).
+ *
+ * @param[inout]	clock		Clock instance
+ * @param[out]		tv		Current time estimate
+ */
+otError ntp_clock_now(struct ntp_clock_t* const clock,
+		struct timeval* tv);
+
+#endif
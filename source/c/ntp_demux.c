@@ -0,0 +1,195 @@
+/* vim: set noet tw=78 si: */
+/*!
+ * OpenThread NTP Client: shared-socket broadcast demultiplexer
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+
+#include "ntp_demux.h"
+#include "ntp_priv.h"
+#include "ntp_mcast.h"
+#include <string.h>
+
+/* The registry hands its clients the LISTEN state machine */
+#if NTP_CLIENT_ENABLE_LISTEN
+
+/*!
+ * Receive handler for the shared socket: fan the message out to every
+ * registered client whose address matches the packet's source or
+ * destination.  Validation and queueing happen per-client in the normal
+ * receive path.
+ */
+static void ntp_listener_registry_recv(
+		void* context, otMessage* msg,
+		const otMessageInfo* msg_info) {
+	struct ntp_listener_registry_t* registry =
+			(struct ntp_listener_registry_t*)context;
+
+	uint8_t i;
+	for (i = 0; i < NTP_LISTENER_REGISTRY_MAX; i++) {
+		struct ntp_client_t* ntp_client =
+				registry->entries[i].ntp_client;
+		if (!ntp_client)
+			continue;
+
+		const otIp6Address* addr = &(registry->entries[i].addr);
+		if (memcmp(addr, &(msg_info->mPeerAddr),
+					sizeof(otIp6Address))
+				&& memcmp(addr, &(msg_info->mSockAddr),
+					sizeof(otIp6Address)))
+			continue;
+
+		_ntp_client_deliver(ntp_client, msg, msg_info);
+	}
+}
+
+/*!
+ * Initialise a registry and bind its shared socket.
+ */
+otError ntp_listener_registry_init(otInstance* instance,
+		struct ntp_listener_registry_t* const registry,
+		uint16_t port) {
+	/* Validate inputs */
+	if (!instance)
+		return OT_ERROR_PARSE;
+	if (!registry)
+		return OT_ERROR_PARSE;
+
+	memset(registry, 0, sizeof(struct ntp_listener_registry_t));
+	registry->instance = instance;
+
+	otError error = otUdpOpen(instance, &(registry->socket),
+			ntp_listener_registry_recv, (void*)registry);
+	if (error != OT_ERROR_NONE)
+		return error;
+	registry->sock_open = true;
+
+	otSockAddr sockaddr;
+	memset(&sockaddr, 0, sizeof(otSockAddr));
+	sockaddr.mPort = port;
+	error = otUdpBind(&(registry->socket), &sockaddr);
+	if (error != OT_ERROR_NONE) {
+		registry->sock_open = false;
+		otUdpClose(&(registry->socket));
+		return error;
+	}
+
+	return error;
+}
+
+/*!
+ * Register a client to receive matching packets.
+ */
+otError ntp_listener_registry_add(
+		struct ntp_listener_registry_t* const registry,
+		struct ntp_client_t* const ntp_client,
+		const otIp6Address* addr,
+		ntp_client_event_handler_t handler,
+		void* handler_context) {
+	/* Validate inputs */
+	if (!registry || !ntp_client || !addr)
+		return OT_ERROR_PARSE;
+	if (!registry->sock_open)
+		return OT_ERROR_INVALID_STATE;
+	if (ntp_client->state)
+		return OT_ERROR_ALREADY;
+
+	/* Find a free slot */
+	uint8_t i;
+	for (i = 0; i < NTP_LISTENER_REGISTRY_MAX; i++) {
+		if (!registry->entries[i].ntp_client)
+			break;
+	}
+	if (i >= NTP_LISTENER_REGISTRY_MAX)
+		return OT_ERROR_NO_BUFS;
+
+	/*
+	 * If multicast, ensure the multicast IP is added.  We don't know if
+	 * it's multicast (OpenThread won't tell us), but we can just try it.
+	 * The reference is released when the client is removed again.
+	 */
+	otError error = ntp_mcast_subscribe(registry->instance, addr);
+	switch (error) {
+	case OT_ERROR_NONE:
+		/* Subscribed; release the reference on removal */
+		registry->entries[i].subscribed = true;
+		break;
+	case OT_ERROR_ALREADY:
+	case OT_ERROR_INVALID_ARGS:
+		/* The application's subscription, or not multicast */
+		registry->entries[i].subscribed = false;
+		break;
+	default:
+		/* We have a problem */
+		return error;
+	}
+
+	/*
+	 * Set the client up listening, but with no socket of its own; the
+	 * registry delivers packets into its receive path.
+	 */
+	memset(ntp_client, 0, sizeof(struct ntp_client_t));
+	ntp_client->instance = registry->instance;
+	ntp_client->handler = handler;
+	ntp_client->handler_context = handler_context;
+	ntp_client->state = NTP_CLIENT_LISTEN;
+
+	registry->entries[i].ntp_client = ntp_client;
+	memcpy(&(registry->entries[i].addr), addr,
+			sizeof(otIp6Address));
+	return OT_ERROR_NONE;
+}
+
+/*!
+ * Remove a previously-registered client.
+ */
+otError ntp_listener_registry_remove(
+		struct ntp_listener_registry_t* const registry,
+		struct ntp_client_t* const ntp_client) {
+	if (!registry || !ntp_client)
+		return OT_ERROR_PARSE;
+
+	uint8_t i;
+	for (i = 0; i < NTP_LISTENER_REGISTRY_MAX; i++) {
+		if (registry->entries[i].ntp_client != ntp_client)
+			continue;
+
+		registry->entries[i].ntp_client = NULL;
+		if (registry->entries[i].subscribed) {
+			registry->entries[i].subscribed = false;
+			ntp_mcast_unsubscribe(registry->instance,
+					&(registry->entries[i].addr));
+		}
+		if (!ntp_client_is_done(ntp_client)) {
+			ntp_client->state = NTP_CLIENT_DONE;
+		}
+		return OT_ERROR_NONE;
+	}
+
+	return OT_ERROR_NOT_FOUND;
+}
+
+/*!
+ * Shutdown the registry.
+ */
+otError ntp_listener_registry_shutdown(
+		struct ntp_listener_registry_t* const registry) {
+	if (!registry)
+		return OT_ERROR_PARSE;
+
+	uint8_t i;
+	for (i = 0; i < NTP_LISTENER_REGISTRY_MAX; i++) {
+		struct ntp_client_t* ntp_client =
+				registry->entries[i].ntp_client;
+		if (ntp_client) {
+			ntp_listener_registry_remove(registry, ntp_client);
+		}
+	}
+
+	if (!registry->sock_open)
+		return OT_ERROR_NONE;
+
+	registry->sock_open = false;
+	return otUdpClose(&(registry->socket));
+}
+
+#endif /* NTP_CLIENT_ENABLE_LISTEN */
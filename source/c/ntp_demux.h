@@ -0,0 +1,101 @@
+/* vim: set tw=78 noet si sw=8 ts=8: */
+/*!
+ * OpenThread NTP Client: shared-socket broadcast demultiplexer
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+#ifndef _NTP_DEMUX_H
+#define _NTP_DEMUX_H
+
+#include "ntp.h"
+
+#if NTP_CLIENT_ENABLE_LISTEN
+
+/*! Maximum number of listeners sharing one registry socket */
+#define NTP_LISTENER_REGISTRY_MAX	(4)
+
+/*!
+ * A registry that fans one UDP socket's received packets out to several
+ * listening NTP clients, matched on source or destination (multicast
+ * group) address.  Running each listener on its own socket costs an
+ * OpenThread socket slot, its RAM, and a traversal of the stack's UDP
+ * demux per packet — all multiplied by the listener count; the registry
+ * pays each of those once.
+ */
+struct ntp_listener_registry_t {
+	/*! OpenThread instance */
+	otInstance*		instance;
+
+	/*! The one shared UDP socket */
+	otUdpSocket		socket;
+
+	/*! Listener slots */
+	struct {
+		/*! Registered client, or NULL if the slot is free */
+		struct ntp_client_t*	ntp_client;
+
+		/*! Source or group address this client wants */
+		otIp6Address		addr;
+
+		/*! True whilst a multicast reference is held on `addr` */
+		bool			subscribed;
+	} entries[NTP_LISTENER_REGISTRY_MAX];
+
+	/*! True whilst `socket` is open */
+	bool			sock_open;
+};
+
+/*!
+ * Initialise a registry and bind its shared socket to the given port on
+ * all addresses.
+ *
+ * @param[inout]	instance	OpenThread instance to use for
+ * 					the registry's context.
+ * @param[inout]	registry	Registry instance
+ * @param[in]		port		Port number to listen on
+ */
+otError ntp_listener_registry_init(otInstance* instance,
+		struct ntp_listener_registry_t* const registry,
+		uint16_t port);
+
+/*!
+ * Register a client to receive packets whose source or destination
+ * matches `addr`.  If `addr` is a multicast group, it is subscribed to.
+ * The client is set up in listening state without a socket of its own;
+ * process it with ntp_client_process() as usual.
+ *
+ * @param[inout]	registry	Registry instance
+ * @param[inout]	ntp_client	NTP client instance
+ * @param[in]		addr		Source or group address to match
+ * @param[in]		handler		NTP event handler
+ * @param[in]		handler_context	NTP event handler context
+ */
+otError ntp_listener_registry_add(
+		struct ntp_listener_registry_t* const registry,
+		struct ntp_client_t* const ntp_client,
+		const otIp6Address* addr,
+		ntp_client_event_handler_t handler,
+		void* handler_context);
+
+/*!
+ * Remove a previously-registered client.  The client is marked done; the
+ * shared socket stays open for the remaining listeners.
+ *
+ * @param[inout]	registry	Registry instance
+ * @param[inout]	ntp_client	NTP client instance
+ */
+otError ntp_listener_registry_remove(
+		struct ntp_listener_registry_t* const registry,
+		struct ntp_client_t* const ntp_client);
+
+/*!
+ * Shutdown the registry: remove every listener and close the shared
+ * socket.
+ *
+ * @param[inout]	registry	Registry instance
+ */
+otError ntp_listener_registry_shutdown(
+		struct ntp_listener_registry_t* const registry);
+
+#endif /* NTP_CLIENT_ENABLE_LISTEN */
+
+#endif
@@ -0,0 +1,216 @@
+/* vim: set noet tw=78 si: */
+/*!
+ * OpenThread NTP Client: manycast server discovery
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+
+#include "ntp_discover.h"
+#include "ntp_wire.h"
+#include "ntp_mcast.h"
+#include <string.h>
+#include <openthread/message.h>
+#include <openthread/platform/alarm-milli.h>
+
+/*! Seconds between the NTP and UNIX epochs */
+#define NTP_DISCOVER_TS_DELTA	(2208988800ull)
+
+/*! Mode field value for a server reply */
+#define NTP_DISCOVER_MODE_SERVER	(4)
+/*! Highest valid stratum for a synchronised server */
+#define NTP_DISCOVER_STRATUM_MAX	(15)
+
+/* Close the probe socket and release the group subscription */
+static void _ntp_discover_close(struct ntp_discover_t* const discover) {
+	if (discover->mcast_subscribed) {
+		discover->mcast_subscribed = false;
+		ntp_mcast_unsubscribe(discover->instance,
+				&(discover->group_addr));
+	}
+	if (!discover->sock_open)
+		return;
+	discover->sock_open = false;
+	otUdpClose(&(discover->socket));
+}
+
+/*
+ * Handler of incoming replies: each responding server is scored by its
+ * round trip (less its own processing time, read from its receive and
+ * transmit time-stamps) and the cheapest one is kept.  This runs in
+ * OpenThread's context; it only ever appends to the best-so-far fields,
+ * which the main loop reads after the window closes.
+ */
+static void ntp_discover_recv(void* context, otMessage* msg,
+		const otMessageInfo* msg_info) {
+	uint32_t rx_ms = otPlatAlarmMilliGetNow();
+	struct ntp_discover_t* discover = (struct ntp_discover_t*)context;
+
+	if (discover->state != NTP_CLIENT_SENT)
+		return;
+
+	uint16_t offset = otMessageGetOffset(msg);
+	uint8_t hdr[4];
+	if (otMessageRead(msg, offset, hdr, sizeof(hdr)) < sizeof(hdr))
+		return;
+	if ((hdr[0] & 0x07) != NTP_DISCOVER_MODE_SERVER)
+		return;
+	if ((hdr[1] < 1) || (hdr[1] > NTP_DISCOVER_STRATUM_MAX))
+		return;
+	if ((otMessageGetLength(msg) - offset) < NTP_WIRE_PACKET_SIZE)
+		return;
+
+	/*
+	 * Round trip as this node saw it, less the interval the server sat
+	 * on the request (its transmit minus receive time-stamps) — a slow
+	 * server on a short path should not lose to a fast server on a
+	 * long one.
+	 */
+	uint8_t stamps[16];
+	if (otMessageRead(msg, offset + NTP_WIRE_OFF_RX_TM_S, stamps,
+			sizeof(stamps)) < sizeof(stamps))
+		return;
+	int64_t t2 = ((int64_t)ntp_wire_get_u32(stamps, 0) * 1000000ll)
+			+ ntp_frac_to_usec(ntp_wire_get_u32(stamps, 4));
+	int64_t t3 = ((int64_t)ntp_wire_get_u32(stamps, 8) * 1000000ll)
+			+ ntp_frac_to_usec(ntp_wire_get_u32(stamps, 12));
+
+	uint32_t delay_ms = rx_ms - discover->tx_ms;
+	if ((t3 > t2) && (((t3 - t2) / 1000) < (int64_t)delay_ms))
+		delay_ms -= (uint32_t)((t3 - t2) / 1000);
+
+	if (!discover->responders
+			|| (delay_ms < discover->best_delay_ms)) {
+		memcpy(&(discover->best_addr), &(msg_info->mPeerAddr),
+				sizeof(otIp6Address));
+		discover->best_delay_ms = delay_ms;
+		discover->best_stratum = hdr[1];
+	}
+	discover->responders++;
+}
+
+/*!
+ * Start a discovery round.
+ */
+otError ntp_discover_begin(otInstance* instance,
+		struct ntp_discover_t* const discover,
+		const otIp6Address* group, uint16_t port,
+		uint8_t ttl, uint32_t window_ms,
+		ntp_discover_handler_t handler,
+		void* handler_context) {
+	/* Validate inputs */
+	if (!instance)
+		return OT_ERROR_PARSE;
+	if (!discover)
+		return OT_ERROR_PARSE;
+	if (discover->state && (discover->state < NTP_CLIENT_DONE))
+		return OT_ERROR_ALREADY;
+	if (!window_ms)
+		window_ms = NTP_DISCOVER_WINDOW_MS;
+
+	memset(discover, 0, sizeof(struct ntp_discover_t));
+	discover->instance = instance;
+	discover->handler = handler;
+	discover->handler_context = handler_context;
+
+	/*
+	 * Join the group so any manycast server response routing that
+	 * depends on membership works; the same tolerant handling as
+	 * ntp_client_listen().  The reference is released when the window
+	 * closes.
+	 */
+	memcpy(&(discover->group_addr), group, sizeof(otIp6Address));
+	discover->error = ntp_mcast_subscribe(instance, group);
+	switch (discover->error) {
+	case OT_ERROR_NONE:
+		discover->mcast_subscribed = true;
+		break;
+	case OT_ERROR_ALREADY:
+	case OT_ERROR_INVALID_ARGS:
+		break;
+	default:
+		return discover->error;
+	}
+
+	discover->error = otUdpOpen(instance, &(discover->socket),
+			ntp_discover_recv, (void*)discover);
+	if (discover->error != OT_ERROR_NONE)
+		return discover->error;
+	discover->sock_open = true;
+
+	/* One probe to the group; responders answer unicast */
+	otMessageSettings msgSettings;
+	msgSettings.mLinkSecurityEnabled = true;
+	msgSettings.mPriority = 0;
+	otMessage* msg = otUdpNewMessage(instance, &msgSettings);
+	if (!msg) {
+		discover->error = OT_ERROR_NO_BUFS;
+		_ntp_discover_close(discover);
+		discover->state = NTP_CLIENT_INT_ERR;
+		return discover->error;
+	}
+
+	uint8_t wire[NTP_WIRE_PACKET_SIZE];
+	memcpy(wire, ntp_wire_request, NTP_WIRE_PACKET_SIZE);
+	gettimeofday(&(discover->tv_tx), NULL);
+	ntp_wire_put_u32(wire, NTP_WIRE_OFF_TX_TM_S, (uint32_t)(
+			discover->tv_tx.tv_sec + NTP_DISCOVER_TS_DELTA));
+	ntp_wire_put_u32(wire, NTP_WIRE_OFF_TX_TM_F, ntp_usec_to_frac(
+			(uint32_t)discover->tv_tx.tv_usec));
+
+	discover->error = otMessageAppend(msg, wire, NTP_WIRE_PACKET_SIZE);
+	if (discover->error == OT_ERROR_NONE) {
+		otMessageInfo msg_info;
+		memset(&msg_info, 0, sizeof(otMessageInfo));
+		memcpy(&(msg_info.mPeerAddr), group,
+				sizeof(otIp6Address));
+		msg_info.mPeerPort = port;
+		msg_info.mHopLimit = ttl;
+		discover->error = otUdpSend(&(discover->socket), msg,
+				&msg_info);
+	}
+
+	if (discover->error != OT_ERROR_NONE) {
+		otMessageFree(msg);
+		_ntp_discover_close(discover);
+		discover->state = NTP_CLIENT_INT_ERR;
+		return discover->error;
+	}
+
+	discover->tx_ms = otPlatAlarmMilliGetNow();
+	discover->window_end_at = discover->tx_ms + window_ms;
+	discover->state = NTP_CLIENT_SENT;
+	return discover->error;
+}
+
+/*!
+ * Process the state of a discovery round.
+ */
+void ntp_discover_process(struct ntp_discover_t* const discover) {
+	if (discover->state != NTP_CLIENT_SENT)
+		return;
+	if (((int32_t)(otPlatAlarmMilliGetNow()
+			- discover->window_end_at)) < 0)
+		return;
+
+	/* The window has closed; the socket has served its purpose */
+	_ntp_discover_close(discover);
+	discover->state = discover->responders
+			? NTP_CLIENT_DONE
+			: NTP_CLIENT_TIMEOUT;
+
+	if (discover->handler)
+		(discover->handler)(discover);
+}
+
+/*!
+ * Fetch the discovered server's address.
+ */
+otError ntp_discover_result(const struct ntp_discover_t* const discover,
+		otIp6Address* addr) {
+	if (!discover || !addr)
+		return OT_ERROR_PARSE;
+	if ((discover->state != NTP_CLIENT_DONE) || !discover->responders)
+		return OT_ERROR_INVALID_STATE;
+
+	memcpy(addr, &(discover->best_addr), sizeof(otIp6Address));
+	return OT_ERROR_NONE;
+}
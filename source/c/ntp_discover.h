@@ -0,0 +1,134 @@
+/* vim: set tw=78 noet si sw=8 ts=8: */
+/*!
+ * OpenThread NTP Client: manycast server discovery
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ *
+ * Discover the nearest NTP server instead of configuring one statically:
+ * one request is sent to a well-known multicast group, every server that
+ * answers within a short window is considered, and the lowest-delay
+ * responder wins.  Its address is then used for ordinary unicast polls
+ * via ntp_client_begin(), so the steady-state path is the short one —
+ * both sync latency and cross-mesh traffic drop to what the nearest
+ * server costs.
+ */
+#ifndef _NTP_DISCOVER_H
+#define _NTP_DISCOVER_H
+
+#include "ntp.h"
+
+/*! Default length of the response-collection window, in milliseconds */
+#define NTP_DISCOVER_WINDOW_MS	(750)
+
+/* Forward declaration */
+struct ntp_discover_t;
+
+/*!
+ * Discovery event handler callback.  Called once when discovery
+ * concludes: the state is NTP_CLIENT_DONE with the best responder in
+ * `best_addr`, or NTP_CLIENT_TIMEOUT if nothing answered.
+ *
+ * @param	discover	Discovery instance
+ */
+typedef void (*ntp_discover_handler_t)(struct ntp_discover_t* discover);
+
+/*!
+ * Manycast discovery state.
+ */
+struct ntp_discover_t {
+	/*! OpenThread instance */
+	otInstance*			instance;
+
+	/*! Event handler callback */
+	ntp_discover_handler_t		handler;
+
+	/*! Event handler callback context */
+	void*				handler_context;
+
+	/*! UDP socket */
+	otUdpSocket			socket;
+
+	/*! Local time-stamp taken when the probe was transmitted */
+	struct timeval			tv_tx;
+
+	/*! Millisecond clock reading when the probe was transmitted */
+	uint32_t			tx_ms;
+
+	/*! Millisecond deadline closing the collection window */
+	uint32_t			window_end_at;
+
+	/*! Address of the lowest-delay responder so far */
+	otIp6Address			best_addr;
+
+	/*! Round-trip delay of the best responder, milliseconds */
+	uint32_t			best_delay_ms;
+
+	/*! Stratum reported by the best responder */
+	uint8_t				best_stratum;
+
+	/*! Number of servers that answered within the window */
+	volatile uint8_t		responders;
+
+	/*! Discovery state (NTP_CLIENT_* values) */
+	volatile uint8_t		state;
+
+	/*! Result state */
+	otError				error;
+
+	/*! True whilst `socket` is open */
+	bool				sock_open;
+
+	/*! The group probed, kept so the subscription can be released */
+	otIp6Address			group_addr;
+
+	/*! True whilst a multicast reference is held on `group_addr` */
+	bool				mcast_subscribed;
+};
+
+/*!
+ * Start a discovery round: subscribe to the group (if it is a multicast
+ * address we are not already a member of), send one probe to it, and
+ * collect responders until the window closes.  Drive the round with
+ * ntp_discover_process() from the main loop.
+ *
+ * @param[inout]	instance	OpenThread instance to use for this
+ * 					discovery's context.
+ * @param[inout]	discover	Discovery instance
+ * @param[in]		group		Multicast group the servers answer on
+ * @param[in]		port		Port number of NTP service
+ * @param[in]		ttl		Message time-to-live
+ * @param[in]		window_ms	Collection window; zero selects the
+ * 					default
+ * @param[in]		handler		Discovery event handler
+ * @param[in]		handler_context	Discovery event handler context
+ */
+otError ntp_discover_begin(otInstance* instance,
+		struct ntp_discover_t* const discover,
+		const otIp6Address* group, uint16_t port,
+		uint8_t ttl, uint32_t window_ms,
+		ntp_discover_handler_t handler,
+		void* handler_context);
+
+/*!
+ * Process the state of a discovery round.  Call in a loop, as with
+ * ntp_client_process(); the handler fires when the window closes.
+ *
+ * @param[inout]	discover	Discovery instance
+ */
+void ntp_discover_process(struct ntp_discover_t* const discover);
+
+/*!
+ * Fetch the discovered server's address, for handing to
+ * ntp_client_begin().
+ *
+ * @param[in]		discover	Discovery instance
+ * @param[out]		addr		Address of the best responder
+ *
+ * @retval	OT_ERROR_NONE		Address written
+ * @retval	OT_ERROR_PARSE		NULL argument
+ * @retval	OT_ERROR_INVALID_STATE	Discovery has not concluded with a
+ * 					responder in hand
+ */
+otError ntp_discover_result(const struct ntp_discover_t* const discover,
+		otIp6Address* addr);
+
+#endif
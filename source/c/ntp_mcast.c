@@ -0,0 +1,96 @@
+/* vim: set noet tw=78 si: */
+/*!
+ * OpenThread NTP Client: multicast subscription registry
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+
+#include "ntp_mcast.h"
+#include <string.h>
+
+/*
+ * The registry is a library-wide table rather than caller-provided state:
+ * unsubscription happens from ntp_client_shutdown(), which only has the
+ * client in hand, and the whole point is to share references between
+ * otherwise unrelated listeners.
+ */
+static struct {
+	/*! OpenThread instance the subscription was made on */
+	otInstance*	instance;
+
+	/*! The subscribed group */
+	otIp6Address	addr;
+
+	/*! References held; zero marks a free slot */
+	uint8_t		refs;
+} _ntp_mcast_table[NTP_MCAST_MAX];
+
+/* Find the slot holding a group, or NTP_MCAST_MAX */
+static uint8_t _ntp_mcast_find(otInstance* instance,
+		const otIp6Address* addr) {
+	uint8_t i;
+	for (i = 0; i < NTP_MCAST_MAX; i++) {
+		if (_ntp_mcast_table[i].refs
+				&& (_ntp_mcast_table[i].instance == instance)
+				&& !memcmp(&(_ntp_mcast_table[i].addr),
+					addr, sizeof(otIp6Address)))
+			return i;
+	}
+	return NTP_MCAST_MAX;
+}
+
+/*!
+ * Subscribe to a multicast group, or reference an existing subscription.
+ */
+otError ntp_mcast_subscribe(otInstance* instance,
+		const otIp6Address* addr) {
+	if (!instance || !addr)
+		return OT_ERROR_PARSE;
+
+	uint8_t i = _ntp_mcast_find(instance, addr);
+	if (i < NTP_MCAST_MAX) {
+		/* Already ours; just take another reference */
+		_ntp_mcast_table[i].refs++;
+		return OT_ERROR_NONE;
+	}
+
+	/* Find a free slot before touching the stack, so a successful
+	 * subscription is never left untracked (and thus unreleasable). */
+	for (i = 0; i < NTP_MCAST_MAX; i++) {
+		if (!_ntp_mcast_table[i].refs)
+			break;
+	}
+	if (i >= NTP_MCAST_MAX)
+		return OT_ERROR_NO_BUFS;
+
+	otError error = otIp6SubscribeMulticastAddress(instance, addr);
+	if (error != OT_ERROR_NONE) {
+		/* ALREADY (application's group) and INVALID_ARGS (not
+		 * multicast) included: nothing for us to track */
+		return error;
+	}
+
+	_ntp_mcast_table[i].instance = instance;
+	memcpy(&(_ntp_mcast_table[i].addr), addr, sizeof(otIp6Address));
+	_ntp_mcast_table[i].refs = 1;
+	return OT_ERROR_NONE;
+}
+
+/*!
+ * Release one reference on a multicast group.
+ */
+otError ntp_mcast_unsubscribe(otInstance* instance,
+		const otIp6Address* addr) {
+	if (!instance || !addr)
+		return OT_ERROR_PARSE;
+
+	uint8_t i = _ntp_mcast_find(instance, addr);
+	if (i >= NTP_MCAST_MAX)
+		return OT_ERROR_NOT_FOUND;
+
+	if (--(_ntp_mcast_table[i].refs))
+		return OT_ERROR_NONE;
+
+	/* Last reference gone; drop the stack subscription */
+	return otIp6UnsubscribeMulticastAddress(instance,
+			&(_ntp_mcast_table[i].addr));
+}
@@ -0,0 +1,54 @@
+/* vim: set tw=78 noet si sw=8 ts=8: */
+/*!
+ * OpenThread NTP Client: multicast subscription registry
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ *
+ * Tracks the multicast groups this library has subscribed to on the
+ * node's behalf, reference-counted across listeners, so the last user of
+ * a group can drop the stack subscription again.  Without this a node
+ * that cycles ntp_client_listen()/ntp_client_shutdown() accumulates
+ * multicast state inside OpenThread and keeps receiving and filtering
+ * group traffic nobody wants — per-packet work on every node in the
+ * group's reach.
+ */
+#ifndef _NTP_MCAST_H
+#define _NTP_MCAST_H
+
+#include <openthread/instance.h>
+#include <openthread/ip6.h>
+
+/*! Distinct multicast groups the registry can track */
+#define NTP_MCAST_MAX	(4)
+
+/*!
+ * Subscribe to a multicast group, or take another reference on it if the
+ * library already holds one.  Groups an application subscribed outside
+ * this library are left alone: the stack reports them with
+ * OT_ERROR_ALREADY and no reference is taken, so they are never
+ * unsubscribed from here.
+ *
+ * @param[inout]	instance	OpenThread instance
+ * @param[in]		addr		Multicast group address
+ *
+ * @retval	OT_ERROR_NONE		Subscribed (a reference is held)
+ * @retval	OT_ERROR_ALREADY	Subscribed outside the library
+ * @retval	OT_ERROR_INVALID_ARGS	Not a multicast address
+ * @retval	OT_ERROR_NO_BUFS	Registry full
+ */
+otError ntp_mcast_subscribe(otInstance* instance,
+		const otIp6Address* addr);
+
+/*!
+ * Release one reference on a multicast group; the stack subscription is
+ * dropped when the last reference goes.
+ *
+ * @param[inout]	instance	OpenThread instance
+ * @param[in]		addr		Multicast group address
+ *
+ * @retval	OT_ERROR_NONE		Reference released
+ * @retval	OT_ERROR_NOT_FOUND	No reference held on this group
+ */
+otError ntp_mcast_unsubscribe(otInstance* instance,
+		const otIp6Address* addr);
+
+#endif
@@ -0,0 +1,117 @@
+/* vim: set noet tw=78 si: */
+/*!
+ * OpenThread NTP Client: multi-server concurrent polling
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+
+#include "ntp_multi.h"
+#include <string.h>
+
+/*!
+ * Poll up to NTP_MULTI_CLIENT_MAX servers in parallel.
+ */
+otError ntp_multi_client_begin(otInstance* instance,
+		struct ntp_multi_client_t* const multi,
+		const otIp6Address* addrs, uint8_t count,
+		uint16_t port, uint8_t ttl,
+		ntp_multi_client_event_handler_t handler,
+		void* handler_context) {
+	/* Validate inputs */
+	if (!instance)
+		return OT_ERROR_PARSE;
+	if (!multi)
+		return OT_ERROR_PARSE;
+	if (!addrs)
+		return OT_ERROR_PARSE;
+	if (!count || (count > NTP_MULTI_CLIENT_MAX))
+		return OT_ERROR_INVALID_ARGS;
+	if (multi->state == NTP_CLIENT_SENT)
+		return OT_ERROR_ALREADY;
+
+	memset(multi, 0, sizeof(struct ntp_multi_client_t));
+	multi->handler = handler;
+	multi->handler_context = handler_context;
+	multi->count = count;
+	multi->winner = -1;
+
+	/*
+	 * Fire a request at every server.  An individual failure (say, no
+	 * free socket slot) still leaves its error in that sub-client; the
+	 * poll proceeds so long as somebody's request got away.
+	 */
+	otError error = OT_ERROR_FAILED;
+	uint8_t i;
+	for (i = 0; i < count; i++) {
+		otError sub = ntp_client_begin(instance,
+				&(multi->clients[i]),
+				&(addrs[i]), port, ttl,
+				NULL, NULL);
+		if (sub == OT_ERROR_NONE)
+			error = OT_ERROR_NONE;
+	}
+
+	if (error != OT_ERROR_NONE) {
+		/* Nothing went out at all */
+		multi->state = NTP_CLIENT_TIMEOUT;
+		return error;
+	}
+
+	multi->state = NTP_CLIENT_SENT;
+	return error;
+}
+
+/*!
+ * Return the sub-client holding the winning reply.
+ */
+struct ntp_client_t* ntp_multi_client_result(
+		struct ntp_multi_client_t* const multi) {
+	if (!multi || (multi->winner < 0))
+		return NULL;
+	return &(multi->clients[multi->winner]);
+}
+
+/*!
+ * Process the state of all sub-clients.
+ */
+void ntp_multi_client_process(struct ntp_multi_client_t* const multi) {
+	if (!multi || (multi->state != NTP_CLIENT_SENT))
+		return;
+
+	bool all_final = true;
+	uint8_t i;
+	for (i = 0; i < multi->count; i++) {
+		struct ntp_client_t* ntp_client = &(multi->clients[i]);
+
+		ntp_client_process(ntp_client);
+
+		if (ntp_client->state == NTP_CLIENT_DONE) {
+			/* First valid reply wins */
+			multi->winner = (int8_t)i;
+			break;
+		}
+
+		if (!ntp_client_is_done(ntp_client))
+			all_final = false;
+	}
+
+	if (multi->winner >= 0) {
+		/* Cancel the requests still outstanding */
+		for (i = 0; i < multi->count; i++) {
+			if ((int8_t)i == multi->winner)
+				continue;
+			if (!ntp_client_is_done(&(multi->clients[i])))
+				ntp_client_shutdown(&(multi->clients[i]));
+		}
+
+		multi->state = NTP_CLIENT_DONE;
+	} else if (all_final) {
+		/* Every server failed or timed out */
+		multi->state = NTP_CLIENT_TIMEOUT;
+	} else {
+		return;
+	}
+
+	if (multi->handler) {
+		(multi->handler)(multi);
+	}
+}
@@ -0,0 +1,95 @@
+/* vim: set tw=78 noet si sw=8 ts=8: */
+/*!
+ * OpenThread NTP Client: multi-server concurrent polling
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+#ifndef _NTP_MULTI_H
+#define _NTP_MULTI_H
+
+#include "ntp.h"
+
+/*! Maximum number of servers polled concurrently */
+#define NTP_MULTI_CLIENT_MAX	(4)
+
+/* Forward declaration */
+struct ntp_multi_client_t;
+
+/*!
+ * Multi-client event handler callback.  Called once when the poll
+ * completes: either a server answered (state NTP_CLIENT_DONE, result via
+ * ntp_multi_client_result()) or every server failed (state
+ * NTP_CLIENT_TIMEOUT).
+ *
+ * @param	multi	Multi-client instance
+ */
+typedef void (*ntp_multi_client_event_handler_t)(
+		struct ntp_multi_client_t* multi);
+
+/*!
+ * Poll engine that fires requests at several NTP servers in parallel and
+ * completes on the first valid reply, cancelling the outstanding
+ * requests.  A dead primary server then costs one round trip to the next
+ * server instead of a full timeout before the next server is even tried.
+ */
+struct ntp_multi_client_t {
+	/*! One sub-client per server, each with its own socket */
+	struct ntp_client_t		clients[NTP_MULTI_CLIENT_MAX];
+
+	/*! Event handler callback */
+	ntp_multi_client_event_handler_t handler;
+
+	/*! Event handler callback context */
+	void*				handler_context;
+
+	/*! Number of servers being polled */
+	uint8_t				count;
+
+	/*! Index of the sub-client that answered first, or -1 */
+	int8_t				winner;
+
+	/*! Engine state; uses the NTP_CLIENT_* state values */
+	volatile uint8_t		state;
+};
+
+/*!
+ * Poll up to NTP_MULTI_CLIENT_MAX servers in parallel.  The poll
+ * succeeds as soon as any server produces a valid reply.  A begin
+ * failure on an individual server (e.g. no free socket) is tolerated so
+ * long as at least one request gets away.
+ *
+ * @param[inout]	instance	OpenThread instance to use for
+ * 					the clients' context.
+ * @param[inout]	multi		Multi-client instance
+ * @param[in]		addrs		Array of NTP server addresses
+ * @param[in]		count		Number of servers
+ * 					(1…NTP_MULTI_CLIENT_MAX)
+ * @param[in]		port		Port number of the NTP servers
+ * @param[in]		ttl		Message time-to-live
+ * @param[in]		handler		Completion handler
+ * @param[in]		handler_context	Completion handler context
+ */
+otError ntp_multi_client_begin(otInstance* instance,
+		struct ntp_multi_client_t* const multi,
+		const otIp6Address* addrs, uint8_t count,
+		uint16_t port, uint8_t ttl,
+		ntp_multi_client_event_handler_t handler,
+		void* handler_context);
+
+/*!
+ * Return the sub-client holding the winning reply (offset, delay and
+ * time-stamp fields), or NULL if the poll has not succeeded.
+ *
+ * @param[in]		multi		Multi-client instance
+ */
+struct ntp_client_t* ntp_multi_client_result(
+		struct ntp_multi_client_t* const multi);
+
+/*!
+ * Process the state of all sub-clients.  This should be called in a
+ * loop, like ntp_client_process().
+ *
+ * @param[inout]	multi		Multi-client instance
+ */
+void ntp_multi_client_process(struct ntp_multi_client_t* const multi);
+
+#endif
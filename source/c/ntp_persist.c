@@ -0,0 +1,87 @@
+/* vim: set noet tw=78 si: */
+/*!
+ * OpenThread NTP Client: last-known-time persistence
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+
+#include "ntp_persist.h"
+#include "ntp_wire.h"
+#include <openthread/platform/alarm-milli.h>
+
+/*! Magic marking a valid image (and its layout version) */
+#define NTP_PERSIST_MAGIC	(0x4e545031)	/* "NTP1" */
+
+/* Byte offsets within the serialized image; all fields big-endian */
+#define NTP_PERSIST_OFF_MAGIC	(0)
+#define NTP_PERSIST_OFF_USEC_HI	(4)
+#define NTP_PERSIST_OFF_USEC_LO	(8)
+#define NTP_PERSIST_OFF_PPB	(12)
+#define NTP_PERSIST_OFF_SUM	(16)
+
+/* Additive checksum over the words ahead of the checksum field */
+static uint32_t _ntp_persist_sum(const uint8_t* buf) {
+	return ntp_wire_get_u32(buf, NTP_PERSIST_OFF_MAGIC)
+		+ ntp_wire_get_u32(buf, NTP_PERSIST_OFF_USEC_HI)
+		+ ntp_wire_get_u32(buf, NTP_PERSIST_OFF_USEC_LO)
+		+ ntp_wire_get_u32(buf, NTP_PERSIST_OFF_PPB);
+}
+
+/*!
+ * Serialize the clock's current state into `buf`.
+ */
+otError ntp_persist_save(struct ntp_clock_t* const clock,
+		uint8_t* buf, uint16_t len) {
+	if (!clock || !buf)
+		return OT_ERROR_PARSE;
+	if (len < NTP_PERSIST_SIZE)
+		return OT_ERROR_NO_BUFS;
+
+	struct timeval tv;
+	otError error = ntp_clock_now(clock, &tv);
+	if (error != OT_ERROR_NONE)
+		return error;
+
+	int64_t usec = ((int64_t)tv.tv_sec * 1000000ll)
+			+ (int64_t)tv.tv_usec;
+
+	ntp_wire_put_u32(buf, NTP_PERSIST_OFF_MAGIC, NTP_PERSIST_MAGIC);
+	ntp_wire_put_u32(buf, NTP_PERSIST_OFF_USEC_HI,
+			(uint32_t)((uint64_t)usec >> 32));
+	ntp_wire_put_u32(buf, NTP_PERSIST_OFF_USEC_LO,
+			(uint32_t)((uint64_t)usec & 0xffffffffull));
+	ntp_wire_put_u32(buf, NTP_PERSIST_OFF_PPB,
+			(uint32_t)clock->freq_ppb);
+	ntp_wire_put_u32(buf, NTP_PERSIST_OFF_SUM, _ntp_persist_sum(buf));
+	return OT_ERROR_NONE;
+}
+
+/*!
+ * Seed a clock from a serialized image, typically at boot.
+ */
+otError ntp_persist_restore(struct ntp_clock_t* const clock,
+		const uint8_t* buf, uint16_t len) {
+	if (!clock || !buf || (len < NTP_PERSIST_SIZE))
+		return OT_ERROR_PARSE;
+
+	if (ntp_wire_get_u32(buf, NTP_PERSIST_OFF_MAGIC)
+			!= NTP_PERSIST_MAGIC)
+		return OT_ERROR_NOT_FOUND;
+	if (ntp_wire_get_u32(buf, NTP_PERSIST_OFF_SUM)
+			!= _ntp_persist_sum(buf))
+		return OT_ERROR_NOT_FOUND;
+
+	int64_t usec = (int64_t)(
+			((uint64_t)ntp_wire_get_u32(buf,
+				NTP_PERSIST_OFF_USEC_HI) << 32)
+			| (uint64_t)ntp_wire_get_u32(buf,
+				NTP_PERSIST_OFF_USEC_LO));
+
+	ntp_clock_init(clock);
+	clock->base_usec = usec;
+	clock->base_ms = otPlatAlarmMilliGetNow();
+	clock->freq_ppb = (int32_t)ntp_wire_get_u32(buf,
+			NTP_PERSIST_OFF_PPB);
+	clock->valid = true;
+	clock->stale = true;
+	return OT_ERROR_NONE;
+}
@@ -0,0 +1,65 @@
+/* vim: set tw=78 noet si sw=8 ts=8: */
+/*!
+ * OpenThread NTP Client: last-known-time persistence
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ *
+ * Serialize the disciplined clock's state — last known time and the
+ * estimated oscillator drift — into a small caller-provided buffer
+ * (typically a flash page), and seed a clock from it at boot.  A restored
+ * clock reports approximate time immediately, microseconds after reset,
+ * instead of stalling everything that needs a clock until the first
+ * successful exchange completes over a possibly-flaky mesh.  The restored
+ * time is flagged stale (ntp_clock_t::stale) until the next live sample,
+ * which steps the clock rather than slewing it.
+ */
+#ifndef _NTP_PERSIST_H
+#define _NTP_PERSIST_H
+
+#include "ntp_clock.h"
+
+/*!
+ * Size of the serialized image, in bytes: magic, time, drift, checksum.
+ */
+#define NTP_PERSIST_SIZE	(20)
+
+/*!
+ * Serialize the clock's current state into `buf`.  The image holds the
+ * disciplined time as of this call, so it should be refreshed
+ * periodically (after each completed poll is the natural place) — on
+ * restore, the clock resumes from the image, and any downtime in between
+ * is unknowable error.
+ *
+ * @param[inout]	clock		Clock instance (read; the read
+ * 					rolls its base forward)
+ * @param[out]		buf		Destination buffer
+ * @param[in]		len		Size of `buf` in bytes, at least
+ * 					NTP_PERSIST_SIZE
+ *
+ * @retval	OT_ERROR_NONE		Image written
+ * @retval	OT_ERROR_PARSE		NULL argument
+ * @retval	OT_ERROR_NO_BUFS	`len` too small
+ * @retval	OT_ERROR_INVALID_STATE	Clock has no time to save
+ */
+otError ntp_persist_save(struct ntp_clock_t* const clock,
+		uint8_t* buf, uint16_t len);
+
+/*!
+ * Seed a clock from a serialized image, typically at boot.  On success
+ * the clock is valid and stale: ntp_clock_now() reports approximate time
+ * (the saved time plus the run time since restore, drift-corrected),
+ * and the next ntp_clock_update() steps straight to the live time.
+ *
+ * @param[inout]	clock		Clock instance to seed
+ * @param[in]		buf		Source buffer
+ * @param[in]		len		Size of `buf` in bytes, at least
+ * 					NTP_PERSIST_SIZE
+ *
+ * @retval	OT_ERROR_NONE		Clock seeded
+ * @retval	OT_ERROR_PARSE		NULL argument or `len` too small
+ * @retval	OT_ERROR_NOT_FOUND	No valid image in `buf` (bad magic
+ * 					or checksum, e.g. erased flash)
+ */
+otError ntp_persist_restore(struct ntp_clock_t* const clock,
+		const uint8_t* buf, uint16_t len);
+
+#endif
@@ -0,0 +1,85 @@
+/* vim: set noet tw=78 si: */
+/*!
+ * OpenThread NTP Client: client pool manager
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+
+#include "ntp_pool.h"
+#include <string.h>
+
+/*!
+ * Initialise a pool over a caller-provided array of clients.
+ */
+otError ntp_client_pool_init(struct ntp_client_pool_t* const pool,
+		struct ntp_client_t* clients, uint8_t count) {
+	/* Validate inputs */
+	if (!pool)
+		return OT_ERROR_PARSE;
+	if (!clients)
+		return OT_ERROR_PARSE;
+	if (!count || (count > NTP_CLIENT_POOL_MAX))
+		return OT_ERROR_INVALID_ARGS;
+
+	memset(clients, 0, count * sizeof(struct ntp_client_t));
+	pool->clients = clients;
+	pool->count = count;
+	pool->active = 0;
+	return OT_ERROR_NONE;
+}
+
+/*!
+ * Return the client at the given index, or NULL if out of range.
+ */
+struct ntp_client_t* ntp_client_pool_get(
+		const struct ntp_client_pool_t* const pool, uint8_t index) {
+	if (!pool || (index >= pool->count))
+		return NULL;
+	return &(pool->clients[index]);
+}
+
+/*!
+ * Mark a client as active so that ntp_client_pool_process() visits it.
+ */
+otError ntp_client_pool_activate(struct ntp_client_pool_t* const pool,
+		uint8_t index) {
+	if (!pool)
+		return OT_ERROR_PARSE;
+	if (index >= pool->count)
+		return OT_ERROR_INVALID_ARGS;
+
+	pool->active |= ((uint32_t)1 << index);
+	return OT_ERROR_NONE;
+}
+
+/*!
+ * Process all active clients in the pool.
+ */
+void ntp_client_pool_process(struct ntp_client_pool_t* const pool) {
+	if (!pool)
+		return;
+
+	/*
+	 * Walk only the set bits; each iteration strips the lowest one, so
+	 * a pool with nothing pending does no per-client work at all.
+	 */
+	uint32_t pending = pool->active;
+	while (pending) {
+		uint8_t index = (uint8_t)__builtin_ctz(pending);
+		pending &= (pending - 1);
+
+		struct ntp_client_t* ntp_client =
+				&(pool->clients[index]);
+		ntp_client_process(ntp_client);
+
+		/*
+		 * Once a client goes idle (back to init, or a final state
+		 * awaiting the application's next move), drop it from the
+		 * bitmap.  The application re-activates it after the next
+		 * ntp_client_begin()/ntp_client_listen().
+		 */
+		if ((ntp_client->state == NTP_CLIENT_INIT)
+				|| ntp_client_is_done(ntp_client)) {
+			pool->active &= ~((uint32_t)1 << index);
+		}
+	}
+}
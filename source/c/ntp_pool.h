@@ -0,0 +1,81 @@
+/* vim: set tw=78 noet si sw=8 ts=8: */
+/*!
+ * OpenThread NTP Client: client pool manager
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+#ifndef _NTP_POOL_H
+#define _NTP_POOL_H
+
+#include "ntp.h"
+
+/*!
+ * Maximum number of clients a pool can manage, bounded by the width of
+ * the activity bitmap.
+ */
+#define NTP_CLIENT_POOL_MAX	(32)
+
+/*!
+ * A pool of NTP clients sharing one process loop.  struct ntp_client_t is
+ * large (it embeds an otUdpSocket and the packet buffer), so walking a
+ * sparse set of them every tick is real cache pressure; the pool instead
+ * keeps a compact bitmap of the clients that actually have work pending
+ * and only touches those.
+ */
+struct ntp_client_pool_t {
+	/*! Contiguous array of clients owned by the pool */
+	struct ntp_client_t*	clients;
+
+	/*! Number of clients in `clients` */
+	uint8_t			count;
+
+	/*!
+	 * Bitmap of active clients: bit N set means clients[N] has work
+	 * pending and will be visited by ntp_client_pool_process().
+	 */
+	uint32_t		active;
+};
+
+/*!
+ * Initialise a pool over a caller-provided array of clients.  The array
+ * is zeroed; all clients start idle.
+ *
+ * @param[inout]	pool		Pool instance
+ * @param[inout]	clients		Client array, at least `count` long
+ * @param[in]		count		Number of clients
+ * 					(at most NTP_CLIENT_POOL_MAX)
+ */
+otError ntp_client_pool_init(struct ntp_client_pool_t* const pool,
+		struct ntp_client_t* clients, uint8_t count);
+
+/*!
+ * Return the client at the given index, or NULL if out of range.
+ *
+ * @param[in]		pool		Pool instance
+ * @param[in]		index		Client index
+ */
+struct ntp_client_t* ntp_client_pool_get(
+		const struct ntp_client_pool_t* const pool, uint8_t index);
+
+/*!
+ * Mark a client as active so that ntp_client_pool_process() visits it.
+ * Call this after successfully starting the client with
+ * ntp_client_begin() / ntp_client_listen() &c.  The pool clears the bit
+ * itself once the client returns to an idle state.
+ *
+ * @param[inout]	pool		Pool instance
+ * @param[in]		index		Client index
+ */
+otError ntp_client_pool_activate(struct ntp_client_pool_t* const pool,
+		uint8_t index);
+
+/*!
+ * Process all active clients in the pool.  Idle clients (state
+ * NTP_CLIENT_INIT or a final state the application has yet to restart)
+ * are skipped via the bitmap and cost no cache misses.  This should be
+ * called in a loop in place of per-client ntp_client_process() calls.
+ *
+ * @param[inout]	pool		Pool instance
+ */
+void ntp_client_pool_process(struct ntp_client_pool_t* const pool);
+
+#endif
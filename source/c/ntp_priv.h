@@ -0,0 +1,33 @@
+/* vim: set tw=78 noet si sw=8 ts=8: */
+/*!
+ * OpenThread NTP Client: internal interfaces shared between modules.
+ * Not installed; nothing here is part of the public API.
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+#ifndef _NTP_PRIV_H
+#define _NTP_PRIV_H
+
+#include "ntp.h"
+#include <openthread/message.h>
+
+/*!
+ * Deliver a received message to a client exactly as if it had arrived on
+ * the client's own socket: validation, time-stamping and event queueing
+ * all apply.  Used by the listener registry to fan one socket's traffic
+ * out to several clients.
+ *
+ * @param[inout]	ntp_client	NTP client instance
+ * @param[in]		msg		Received message
+ * @param[in]		msg_info	Message metadata
+ */
+void _ntp_client_deliver(struct ntp_client_t* const ntp_client,
+		otMessage* msg, const otMessageInfo* msg_info);
+
+/*!
+ * True if millisecond time `now` is at or past `deadline`, modulo 2³².
+ */
+static inline bool _ntp_ms_reached(uint32_t now, uint32_t deadline) {
+	return ((int32_t)(now - deadline)) >= 0;
+}
+
+#endif
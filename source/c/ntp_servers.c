@@ -0,0 +1,146 @@
+/* vim: set noet tw=78 si: */
+/*!
+ * OpenThread NTP Client: server-quality cache
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+
+#include "ntp_servers.h"
+#include <string.h>
+
+/*! Milliseconds of equivalent delay each stratum level costs a server */
+#define NTP_SERVER_STRATUM_COST_MS	(8)
+
+/*
+ * Score an entry; lower is better.  The delay term (round trip plus a
+ * small per-stratum penalty, so a stratum-2 server beats an equally-fast
+ * stratum-10 one) is scaled up by the inverse of the reply rate: a server
+ * answering half its polls effectively costs twice its round trip, and
+ * one that has stopped answering scores its way out of contention within
+ * a few timeouts.
+ */
+static uint32_t _ntp_server_score(
+		const struct ntp_server_entry_t* const entry) {
+	uint32_t delay_ms = entry->rtt_ewma_ms
+			+ ((uint32_t)entry->stratum
+				* NTP_SERVER_STRATUM_COST_MS)
+			+ 1;
+	return (delay_ms * NTP_SERVER_RATE_FULL)
+			/ ((uint32_t)entry->reply_rate + 1);
+}
+
+/* Find the entry for `addr`, or NULL */
+static struct ntp_server_entry_t* _ntp_server_find(
+		struct ntp_server_cache_t* const cache,
+		const otIp6Address* addr) {
+	uint8_t idx;
+	for (idx = 0; idx < NTP_SERVER_CACHE_MAX; idx++) {
+		if (cache->entries[idx].used
+				&& !memcmp(&(cache->entries[idx].addr),
+					addr, sizeof(otIp6Address)))
+			return &(cache->entries[idx]);
+	}
+	return NULL;
+}
+
+/* Take a free slot, or evict the worst-scoring entry */
+static struct ntp_server_entry_t* _ntp_server_alloc(
+		struct ntp_server_cache_t* const cache,
+		const otIp6Address* addr) {
+	struct ntp_server_entry_t* victim = NULL;
+	uint32_t victim_score = 0;
+	uint8_t idx;
+
+	for (idx = 0; idx < NTP_SERVER_CACHE_MAX; idx++) {
+		struct ntp_server_entry_t* entry = &(cache->entries[idx]);
+		if (!entry->used) {
+			victim = entry;
+			break;
+		}
+		uint32_t score = _ntp_server_score(entry);
+		if (!victim || (score > victim_score)) {
+			victim = entry;
+			victim_score = score;
+		}
+	}
+
+	memset(victim, 0, sizeof(struct ntp_server_entry_t));
+	memcpy(&(victim->addr), addr, sizeof(otIp6Address));
+	victim->used = true;
+	return victim;
+}
+
+/*!
+ * Initialise (or reset) a server cache.
+ */
+void ntp_server_cache_init(struct ntp_server_cache_t* const cache) {
+	if (!cache)
+		return;
+	memset(cache, 0, sizeof(struct ntp_server_cache_t));
+}
+
+/*!
+ * Fold a concluded poll into the cache.
+ */
+otError ntp_server_cache_update(struct ntp_server_cache_t* const cache,
+		const struct ntp_client_t* const ntp_client) {
+	if (!cache || !ntp_client)
+		return OT_ERROR_PARSE;
+	if (!ntp_client_is_done(ntp_client))
+		return OT_ERROR_INVALID_STATE;
+
+	struct ntp_server_entry_t* entry = _ntp_server_find(cache,
+			&(ntp_client->peer_addr));
+	if (!entry)
+		entry = _ntp_server_alloc(cache,
+				&(ntp_client->peer_addr));
+
+	if (ntp_client->state == NTP_CLIENT_DONE) {
+		uint32_t rtt_ms = (ntp_client->delay > 0)
+				? (uint32_t)(ntp_client->delay / 1000)
+				: 0;
+		if (!rtt_ms)
+			rtt_ms = 1;
+
+		/* Fold the sample in with the usual α = ¼ */
+		entry->rtt_ewma_ms = entry->rtt_ewma_ms
+				? (((3 * entry->rtt_ewma_ms) + rtt_ms) / 4)
+				: rtt_ms;
+		entry->reply_rate = (uint16_t)(
+				((3 * (uint32_t)entry->reply_rate)
+					+ NTP_SERVER_RATE_FULL) / 4);
+		entry->stratum = ntp_client->srv_stratum;
+	} else {
+		/* Timeout, KoD or comms error: no reply worth having */
+		entry->reply_rate = (uint16_t)(
+				(3 * (uint32_t)entry->reply_rate) / 4);
+	}
+
+	return OT_ERROR_NONE;
+}
+
+/*!
+ * Return the best server currently in the cache, or NULL.
+ */
+const otIp6Address* ntp_server_select(
+		const struct ntp_server_cache_t* const cache) {
+	const struct ntp_server_entry_t* best = NULL;
+	uint32_t best_score = 0;
+	uint8_t idx;
+
+	if (!cache)
+		return NULL;
+
+	for (idx = 0; idx < NTP_SERVER_CACHE_MAX; idx++) {
+		const struct ntp_server_entry_t* entry
+				= &(cache->entries[idx]);
+		if (!entry->used)
+			continue;
+		uint32_t score = _ntp_server_score(entry);
+		if (!best || (score < best_score)) {
+			best = entry;
+			best_score = score;
+		}
+	}
+
+	return best ? &(best->addr) : NULL;
+}
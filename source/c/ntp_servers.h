@@ -0,0 +1,89 @@
+/* vim: set tw=78 noet si sw=8 ts=8: */
+/*!
+ * OpenThread NTP Client: server-quality cache
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ *
+ * A small fixed table remembering how each NTP server has performed:
+ * EWMA round-trip delay, reply rate and last reported stratum, keyed by
+ * address and updated from each concluded poll.  ntp_server_select()
+ * returns the current best so the application polls the server most
+ * likely to answer quickly, instead of burning a full reply timeout
+ * re-trying one the node already knows is down.
+ */
+#ifndef _NTP_SERVERS_H
+#define _NTP_SERVERS_H
+
+#include "ntp.h"
+
+/*! Number of servers the cache can track */
+#ifndef NTP_SERVER_CACHE_MAX
+#define NTP_SERVER_CACHE_MAX	(8)
+#endif
+
+/*! Full-scale value of the reply-rate EWMA (every poll answered) */
+#define NTP_SERVER_RATE_FULL	(256)
+
+/*! One tracked server */
+struct ntp_server_entry_t {
+	/*! The server's address; the table key */
+	otIp6Address		addr;
+
+	/*! EWMA round-trip delay, milliseconds (0 = no reply yet) */
+	uint32_t		rtt_ewma_ms;
+
+	/*!
+	 * EWMA reply rate, 0…NTP_SERVER_RATE_FULL.  Each concluded poll
+	 * folds in NTP_SERVER_RATE_FULL (answered) or 0 (timed out).
+	 */
+	uint16_t		reply_rate;
+
+	/*! Stratum from the most recent reply (0 = none yet) */
+	uint8_t			stratum;
+
+	/*! True while this slot holds a server */
+	bool			used;
+};
+
+/*! The server-quality cache */
+struct ntp_server_cache_t {
+	/*! Tracked servers */
+	struct ntp_server_entry_t	entries[NTP_SERVER_CACHE_MAX];
+};
+
+/*!
+ * Initialise (or reset) a server cache.
+ *
+ * @param[inout]	cache		Cache instance
+ */
+void ntp_server_cache_init(struct ntp_server_cache_t* const cache);
+
+/*!
+ * Fold a concluded poll into the cache.  Call this when the client
+ * reaches a final state (from the event handler, or after
+ * ntp_client_process() reports ntp_client_is_done()): NTP_CLIENT_DONE
+ * counts as a reply with the client's measured delay and stratum, any
+ * other final state counts as a failure.  A server not yet in the cache
+ * takes a free slot, or evicts the worst-scoring entry.
+ *
+ * @param[inout]	cache		Cache instance
+ * @param[in]		ntp_client	Concluded client
+ *
+ * @retval	OT_ERROR_NONE		Cache updated
+ * @retval	OT_ERROR_PARSE		NULL argument
+ * @retval	OT_ERROR_INVALID_STATE	The client's poll has not concluded
+ */
+otError ntp_server_cache_update(struct ntp_server_cache_t* const cache,
+		const struct ntp_client_t* const ntp_client);
+
+/*!
+ * Return the best server currently in the cache, or NULL if the cache is
+ * empty.  Servers that answer reliably with low delay and low stratum
+ * score ahead of lossy, slow or distant ones; a server that has stopped
+ * answering decays out of contention after a few timeouts.
+ *
+ * @param[in]		cache		Cache instance
+ */
+const otIp6Address* ntp_server_select(
+		const struct ntp_server_cache_t* const cache);
+
+#endif
@@ -0,0 +1,186 @@
+/* vim: set noet tw=78 si: */
+/*!
+ * OpenThread NTP Client: shared timer wheel
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+
+#include "ntp_wheel.h"
+#include "ntp_priv.h"
+#include <string.h>
+#include <openthread/platform/alarm-milli.h>
+
+/* Slot a millisecond deadline hashes into */
+static inline uint8_t _ntp_wheel_slot(uint32_t deadline) {
+	return (uint8_t)((deadline / NTP_WHEEL_SLOT_MS)
+			& (NTP_WHEEL_SLOTS - 1));
+}
+
+/* Find the entry index for a client, or NTP_WHEEL_MAX */
+static uint8_t _ntp_wheel_find(const struct ntp_wheel_t* const wheel,
+		const struct ntp_client_t* const ntp_client) {
+	uint32_t pending = wheel->used;
+	while (pending) {
+		uint8_t idx = (uint8_t)__builtin_ctz(pending);
+		pending &= (pending - 1);
+		if (wheel->clients[idx] == ntp_client)
+			return idx;
+	}
+	return NTP_WHEEL_MAX;
+}
+
+/* Clear an entry out of its slot and the used bitmap */
+static void _ntp_wheel_clear(struct ntp_wheel_t* const wheel, uint8_t idx) {
+	uint32_t bit = ((uint32_t)1 << idx);
+	wheel->slots[_ntp_wheel_slot(wheel->deadlines[idx])] &= ~bit;
+	wheel->used &= ~bit;
+	wheel->clients[idx] = NULL;
+}
+
+/*!
+ * Initialise (or reset) a timer wheel.
+ */
+void ntp_wheel_init(struct ntp_wheel_t* const wheel) {
+	if (!wheel)
+		return;
+	memset(wheel, 0, sizeof(struct ntp_wheel_t));
+	wheel->last_ms = otPlatAlarmMilliGetNow();
+}
+
+/*!
+ * Register (or refresh) a client's pending deadline with the wheel.
+ */
+otError ntp_wheel_schedule(struct ntp_wheel_t* const wheel,
+		struct ntp_client_t* const ntp_client) {
+	if (!wheel || !ntp_client)
+		return OT_ERROR_PARSE;
+	if ((ntp_client->state != NTP_CLIENT_SENT)
+			&& (ntp_client->state != NTP_CLIENT_SEND_PEND))
+		return OT_ERROR_INVALID_STATE;
+
+	/*
+	 * The next thing due: the reply timeout, the next burst send, or
+	 * the re-attempt of a transmission deferred for buffers.
+	 */
+	uint32_t deadline = ntp_client->timeout_at;
+	if (ntp_client->burst_count
+			&& (ntp_client->burst_sent
+				< ntp_client->burst_count)
+			&& !_ntp_ms_reached(ntp_client->burst_next_at,
+				deadline))
+		deadline = ntp_client->burst_next_at;
+	if ((ntp_client->state == NTP_CLIENT_SEND_PEND)
+			&& !_ntp_ms_reached(ntp_client->send_retry_at,
+				deadline))
+		deadline = ntp_client->send_retry_at;
+
+	uint8_t idx = _ntp_wheel_find(wheel, ntp_client);
+	if (idx < NTP_WHEEL_MAX) {
+		/* Already registered: move it to the new deadline's slot */
+		_ntp_wheel_clear(wheel, idx);
+	} else {
+		if (wheel->used == UINT32_MAX)
+			return OT_ERROR_NO_BUFS;
+		idx = (uint8_t)__builtin_ctz(~wheel->used);
+	}
+
+	uint32_t bit = ((uint32_t)1 << idx);
+	wheel->clients[idx] = ntp_client;
+	wheel->deadlines[idx] = deadline;
+	wheel->used |= bit;
+	wheel->slots[_ntp_wheel_slot(deadline)] |= bit;
+	return OT_ERROR_NONE;
+}
+
+/*!
+ * Drop a client from the wheel.
+ */
+otError ntp_wheel_remove(struct ntp_wheel_t* const wheel,
+		const struct ntp_client_t* const ntp_client) {
+	if (!wheel || !ntp_client)
+		return OT_ERROR_PARSE;
+
+	uint8_t idx = _ntp_wheel_find(wheel, ntp_client);
+	if (idx >= NTP_WHEEL_MAX)
+		return OT_ERROR_NOT_FOUND;
+
+	_ntp_wheel_clear(wheel, idx);
+	return OT_ERROR_NONE;
+}
+
+/*!
+ * Advance the wheel to the current millisecond clock and process every
+ * client whose deadline expired.
+ */
+void ntp_wheel_process(struct ntp_wheel_t* const wheel) {
+	if (!wheel)
+		return;
+
+	uint32_t now = otPlatAlarmMilliGetNow();
+	uint32_t steps = (now / NTP_WHEEL_SLOT_MS)
+			- (wheel->last_ms / NTP_WHEEL_SLOT_MS);
+	if (steps > NTP_WHEEL_SLOTS)
+		steps = NTP_WHEEL_SLOTS;
+	uint8_t from = (uint8_t)((wheel->last_ms / NTP_WHEEL_SLOT_MS)
+			& (NTP_WHEEL_SLOTS - 1));
+	wheel->last_ms = now;
+
+	/*
+	 * Inspect the current slot plus every slot crossed since the last
+	 * call.  Entries hashed there whose deadline is a lap (or more)
+	 * away stay put; they cost one bitmap hit per lap.
+	 */
+	uint32_t step;
+	for (step = 0; step <= steps; step++) {
+		uint8_t slot = (uint8_t)((from + step)
+				& (NTP_WHEEL_SLOTS - 1));
+		uint32_t pending = wheel->slots[slot];
+		while (pending) {
+			uint8_t idx = (uint8_t)__builtin_ctz(pending);
+			pending &= (pending - 1);
+
+			if (!_ntp_ms_reached(now, wheel->deadlines[idx]))
+				continue;
+
+			struct ntp_client_t* ntp_client =
+					wheel->clients[idx];
+			_ntp_wheel_clear(wheel, idx);
+			ntp_client_process(ntp_client);
+
+			/*
+			 * A retransmission or burst send arms a fresh
+			 * deadline; keep tracking it.  Anything else
+			 * (concluded, or back in the application's hands)
+			 * stays dropped.
+			 */
+			if ((ntp_client->state == NTP_CLIENT_SENT)
+					|| (ntp_client->state
+						== NTP_CLIENT_SEND_PEND))
+				ntp_wheel_schedule(wheel, ntp_client);
+		}
+	}
+}
+
+/*!
+ * Return the number of milliseconds until the earliest registered
+ * deadline.
+ */
+uint32_t ntp_wheel_next_in(const struct ntp_wheel_t* const wheel) {
+	uint32_t next = UINT32_MAX;
+	uint32_t now = otPlatAlarmMilliGetNow();
+
+	if (!wheel)
+		return next;
+
+	uint32_t pending = wheel->used;
+	while (pending) {
+		uint8_t idx = (uint8_t)__builtin_ctz(pending);
+		pending &= (pending - 1);
+
+		if (_ntp_ms_reached(now, wheel->deadlines[idx]))
+			return 0;
+		uint32_t in = wheel->deadlines[idx] - now;
+		if (in < next)
+			next = in;
+	}
+	return next;
+}
@@ -0,0 +1,114 @@
+/* vim: set tw=78 noet si sw=8 ts=8: */
+/*!
+ * OpenThread NTP Client: shared timer wheel
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ *
+ * One structure managing the reply deadlines of many clients.  Each
+ * pending client registers its deadline in a hashed wheel slot; one call
+ * to ntp_wheel_process() inspects only the slots the millisecond clock
+ * has crossed since the last call and drives ntp_client_process() for the
+ * clients whose deadlines actually expired.  The per-call cost is one
+ * slot-bitmap inspection rather than a state check per client, which is
+ * what matters once the concurrent-client count grows past a handful.
+ *
+ * The wheel handles deadline-driven work only: when a reply *arrives*,
+ * process the client as usual (the receive event makes that call cheap
+ * and immediate).
+ */
+#ifndef _NTP_WHEEL_H
+#define _NTP_WHEEL_H
+
+#include "ntp.h"
+
+/*! Clients the wheel can track; sized to the bitmap word */
+#define NTP_WHEEL_MAX		(32)
+
+/*! Wheel slots; must be a power of two */
+#define NTP_WHEEL_SLOTS		(16)
+
+/*!
+ * Width of one slot in milliseconds.  Deadlines are fired at slot
+ * granularity; the wheel spans NTP_WHEEL_SLOTS × this before deadlines
+ * share a slot across laps (which costs one spurious inspection per lap,
+ * nothing more).
+ */
+#define NTP_WHEEL_SLOT_MS	(256)
+
+/*! The timer wheel */
+struct ntp_wheel_t {
+	/*! Registered clients, by entry index */
+	struct ntp_client_t*	clients[NTP_WHEEL_MAX];
+
+	/*! Absolute millisecond deadline of each entry */
+	uint32_t		deadlines[NTP_WHEEL_MAX];
+
+	/*! Bitmap of entries in use */
+	uint32_t		used;
+
+	/*! Per-slot bitmaps of the entries hashed into that slot */
+	uint32_t		slots[NTP_WHEEL_SLOTS];
+
+	/*! Millisecond clock reading at the last process call */
+	uint32_t		last_ms;
+};
+
+/*!
+ * Initialise (or reset) a timer wheel.
+ *
+ * @param[inout]	wheel		Wheel instance
+ */
+void ntp_wheel_init(struct ntp_wheel_t* const wheel);
+
+/*!
+ * Register (or refresh) a client's pending deadline with the wheel.
+ * Call after ntp_client_begin() succeeds; the wheel re-registers the
+ * client itself when a retransmission or burst send arms a new deadline.
+ * The deadline used is the earlier of the reply timeout and the next
+ * burst transmission.
+ *
+ * @param[inout]	wheel		Wheel instance
+ * @param[in]		ntp_client	Client with a pending request
+ *
+ * @retval	OT_ERROR_NONE		Deadline registered
+ * @retval	OT_ERROR_PARSE		NULL argument
+ * @retval	OT_ERROR_INVALID_STATE	The client has no pending deadline
+ * @retval	OT_ERROR_NO_BUFS	The wheel is full
+ */
+otError ntp_wheel_schedule(struct ntp_wheel_t* const wheel,
+		struct ntp_client_t* const ntp_client);
+
+/*!
+ * Drop a client from the wheel (e.g. on ntp_client_shutdown()).  A
+ * client whose poll concludes through the wheel is dropped
+ * automatically.
+ *
+ * @param[inout]	wheel		Wheel instance
+ * @param[in]		ntp_client	Client to drop
+ *
+ * @retval	OT_ERROR_NONE		Client dropped
+ * @retval	OT_ERROR_PARSE		NULL argument
+ * @retval	OT_ERROR_NOT_FOUND	Client was not registered
+ */
+otError ntp_wheel_remove(struct ntp_wheel_t* const wheel,
+		const struct ntp_client_t* const ntp_client);
+
+/*!
+ * Advance the wheel to the current millisecond clock and process every
+ * client whose deadline expired.  Clients that arm a fresh deadline
+ * (retransmission, next burst send) are re-registered; concluded ones
+ * are dropped.
+ *
+ * @param[inout]	wheel		Wheel instance
+ */
+void ntp_wheel_process(struct ntp_wheel_t* const wheel);
+
+/*!
+ * Return the number of milliseconds until the earliest registered
+ * deadline, for driving a wake-up timer; zero if a deadline is already
+ * due, UINT32_MAX if the wheel is empty.
+ *
+ * @param[in]		wheel		Wheel instance
+ */
+uint32_t ntp_wheel_next_in(const struct ntp_wheel_t* const wheel);
+
+#endif
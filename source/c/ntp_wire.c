@@ -0,0 +1,15 @@
+/* vim: set noet tw=78 si: */
+/*!
+ * OpenThread NTP Client: NTP wire format
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ */
+
+#include "ntp_wire.h"
+
+/*!
+ * A complete, constant client request image.  Only byte 0 is non-zero:
+ * li = 0, vn = 3, mode = 3.
+ */
+const uint8_t ntp_wire_request[NTP_WIRE_PACKET_SIZE] = {
+	NTP_WIRE_REQUEST_FLAGS,
+};
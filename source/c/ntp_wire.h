@@ -0,0 +1,84 @@
+/* vim: set tw=78 noet si sw=8 ts=8: */
+/*!
+ * OpenThread NTP Client: NTP wire format
+ * (C) 2018 VRT Systems <http://www.vrt.com.au>.
+ *
+ * Explicit byte offsets and accessors for the 48-byte NTP packet.  The
+ * packet used to be described by a C struct led by bitfields, whose
+ * layout is compiler- and endian-dependent; everything here is defined
+ * in terms of bytes on the wire and works on any toolchain.
+ */
+#ifndef _NTP_WIRE_H
+#define _NTP_WIRE_H
+
+#include <stdint.h>
+
+/*! Size of an NTP packet on the wire */
+#define NTP_WIRE_PACKET_SIZE	(48)
+
+/*! Leap indicator / version / mode byte */
+#define NTP_WIRE_OFF_FLAGS	(0)
+/*! Stratum level of the clock */
+#define NTP_WIRE_OFF_STRATUM	(1)
+/*! Maximum interval between successive messages, log₂ seconds */
+#define NTP_WIRE_OFF_POLL	(2)
+/*! Precision of the clock, log₂ seconds */
+#define NTP_WIRE_OFF_PRECISION	(3)
+/*! Total round trip delay to the reference clock */
+#define NTP_WIRE_OFF_ROOT_DELAY	(4)
+/*! Maximum error relative to the reference clock */
+#define NTP_WIRE_OFF_ROOT_DISP	(8)
+/*! Reference clock identifier (or Kiss-o'-Death code) */
+#define NTP_WIRE_OFF_REF_ID	(12)
+/*! Reference time-stamp seconds / fraction */
+#define NTP_WIRE_OFF_REF_TM_S	(16)
+#define NTP_WIRE_OFF_REF_TM_F	(20)
+/*! Originate time-stamp seconds / fraction */
+#define NTP_WIRE_OFF_ORIG_TM_S	(24)
+#define NTP_WIRE_OFF_ORIG_TM_F	(28)
+/*! Receive time-stamp seconds / fraction */
+#define NTP_WIRE_OFF_RX_TM_S	(32)
+#define NTP_WIRE_OFF_RX_TM_F	(36)
+/*! Transmit time-stamp seconds / fraction */
+#define NTP_WIRE_OFF_TX_TM_S	(40)
+#define NTP_WIRE_OFF_TX_TM_F	(44)
+
+/*! First byte of a client request: li = 0, vn = 3, mode = 3 */
+#define NTP_WIRE_REQUEST_FLAGS	(0x1b)
+
+/*!
+ * A complete, constant client request image: flags byte set, every
+ * other field zero.  A request only ever differs from this in its
+ * transmit time-stamp, so building one is a copy plus two stores.
+ */
+extern const uint8_t ntp_wire_request[NTP_WIRE_PACKET_SIZE];
+
+/*!
+ * Read a 32-bit big-endian field from a packet buffer.
+ *
+ * @param[in]	buf	Packet buffer
+ * @param[in]	off	Byte offset of the field (NTP_WIRE_OFF_*)
+ */
+static inline uint32_t ntp_wire_get_u32(const uint8_t* buf, uint16_t off) {
+	return ((uint32_t)buf[off] << 24)
+		| ((uint32_t)buf[off + 1] << 16)
+		| ((uint32_t)buf[off + 2] << 8)
+		| ((uint32_t)buf[off + 3]);
+}
+
+/*!
+ * Write a 32-bit field to a packet buffer in big-endian order.
+ *
+ * @param[out]	buf	Packet buffer
+ * @param[in]	off	Byte offset of the field (NTP_WIRE_OFF_*)
+ * @param[in]	val	Value, host byte order
+ */
+static inline void ntp_wire_put_u32(uint8_t* buf, uint16_t off,
+		uint32_t val) {
+	buf[off] = (uint8_t)(val >> 24);
+	buf[off + 1] = (uint8_t)(val >> 16);
+	buf[off + 2] = (uint8_t)(val >> 8);
+	buf[off + 3] = (uint8_t)val;
+}
+
+#endif